@@ -13,13 +13,24 @@ import java.util.*
 
 class BluetoothManager(private val context: Context) {
 
+    companion object {
+        private const val SNAPSHOT_LEN = 24
+        private const val SNAPSHOT_BATCH_TAG = 0x81
+        private const val SNAPSHOT_BATCH_MAX = 10
+        private const val SNAPSHOT_MTU = 247 // fits a full batch of 10 records
+    }
+
     interface BluetoothListener {
         fun onDevicesFound(devices: List<BluetoothDevice>)
         fun onConnectionStateChanged(connected: Boolean, message: String)
         fun onGasDataUpdated(co: Float, no2: Float, nh3: Float, ch4: Float, etoh: Float)
         fun onEnvDataUpdated(temp: Float, humidity: Float)
-        fun onSoundDetected(count: Int)
+        fun onSoundDetected(count: Int) // events in the last sound window
         fun onError(message: String)
+
+        // Backlog download from the flash log, see SampleLogDecoder.Record
+        fun onBacklogRecord(seq: Long, boot: Int, timestampMs: Long, kind: Int, values: FloatArray) {}
+        fun onBacklogComplete(nextSeq: Long) {}
     }
 
     private var listener: BluetoothListener? = null
@@ -32,12 +43,16 @@ class BluetoothManager(private val context: Context) {
 
     private var isConnected = false
     private var isScanning = false
+    private var batchSize = 0 // snapshot records per notification, 0 = live
 
     // UUIDs EXACTOS
     private val SERVICE_UUID = UUID.fromString("47617353-656e-736f-7253-766300000000")
     private val GAS_CHAR_UUID = UUID.fromString("47617352-6561-6469-6e67-730000000000")
     private val ENV_CHAR_UUID = UUID.fromString("456e7669-726f-6e6d-656e-740000000000")
     private val SND_CHAR_UUID = UUID.fromString("536f756e-6444-6574-6563-740000000000")
+    private val SNAP_CHAR_UUID = UUID.fromString("536e6170-7368-6f74-5631-000000000000")
+    private val MODE_CHAR_UUID = UUID.fromString("4e6f7469-6679-4d6f-6465-000000000000")
+    private val LOG_CHAR_UUID = UUID.fromString("4c6f6744-756d-7056-3100-000000000000")
     private val CCCD_UUID = UUID.fromString("00002902-0000-1000-8000-00805f9b34fb")
 
     fun setListener(listener: BluetoothListener) {
@@ -94,6 +109,38 @@ class BluetoothManager(private val context: Context) {
         handler.post { listener?.onConnectionStateChanged(false, "Desconectado") }
     }
 
+    /**
+     * Selects how many snapshot records the device packs into one
+     * notification (0 = one per reading, up to 10). Larger batches mean
+     * fewer radio events overnight, at the cost of update latency.
+     */
+    fun setBatchSize(records: Int) {
+        batchSize = records.coerceIn(0, SNAPSHOT_BATCH_MAX)
+        gatt?.let { if (isConnected) writeBatchSize(it) }
+    }
+
+    /**
+     * Streams every record stored on the device from log sequence number
+     * fromSeq (1 = everything still in flash). Records arrive through
+     * onBacklogRecord, then onBacklogComplete with the seq to resume from.
+     */
+    @SuppressLint("MissingPermission")
+    fun downloadBacklog(fromSeq: Long) {
+        val g = gatt ?: return
+        val log = g.getService(SERVICE_UUID)?.getCharacteristic(LOG_CHAR_UUID) ?: return
+        log.value = ByteBuffer.allocate(4).order(ByteOrder.LITTLE_ENDIAN).putInt(fromSeq.toInt()).array()
+        log.writeType = BluetoothGattCharacteristic.WRITE_TYPE_DEFAULT
+        g.writeCharacteristic(log)
+    }
+
+    @SuppressLint("MissingPermission")
+    private fun writeBatchSize(gatt: BluetoothGatt) {
+        val mode = gatt.getService(SERVICE_UUID)?.getCharacteristic(MODE_CHAR_UUID) ?: return
+        mode.value = byteArrayOf(batchSize.toByte())
+        mode.writeType = BluetoothGattCharacteristic.WRITE_TYPE_DEFAULT
+        gatt.writeCharacteristic(mode)
+    }
+
     private val scanCallback = object : ScanCallback() {
         override fun onScanResult(type: Int, result: ScanResult) {
             if (foundDevices.add(result.device)) {
@@ -142,7 +189,12 @@ class BluetoothManager(private val context: Context) {
                 val service = gatt.getService(SERVICE_UUID)
                 if (service != null) {
                     Log.d("BLE_DEBUG", "Target service found!")
-                    enableNotification(gatt, service, GAS_CHAR_UUID)
+                    if (service.getCharacteristic(SNAP_CHAR_UUID) != null) {
+                        // The 24-byte snapshot does not fit the default 23-byte MTU
+                        gatt.requestMtu(SNAPSHOT_MTU)
+                    } else {
+                        enableNotification(gatt, service, GAS_CHAR_UUID)
+                    }
                 } else {
                     Log.e("BLE_DEBUG", "Target service NOT found: $SERVICE_UUID")
                     handler.post { listener?.onError("Servicio no encontrado") }
@@ -152,6 +204,17 @@ class BluetoothManager(private val context: Context) {
             }
         }
 
+        @SuppressLint("MissingPermission")
+        override fun onMtuChanged(gatt: BluetoothGatt, mtu: Int, status: Int) {
+            Log.d("BLE_DEBUG", "onMtuChanged: mtu=$mtu, status=$status")
+            val service = gatt.getService(SERVICE_UUID) ?: return
+            if (status == BluetoothGatt.GATT_SUCCESS && mtu - 3 >= SNAPSHOT_LEN) {
+                enableNotification(gatt, service, SNAP_CHAR_UUID)
+            } else {
+                enableNotification(gatt, service, GAS_CHAR_UUID)
+            }
+        }
+
         @SuppressLint("MissingPermission")
         private fun enableNotification(gatt: BluetoothGatt, service: BluetoothGattService, charUuid: UUID) {
             val characteristic = service.getCharacteristic(charUuid)
@@ -176,12 +239,21 @@ class BluetoothManager(private val context: Context) {
             when (descriptor.characteristic.uuid) {
                 GAS_CHAR_UUID -> enableNotification(gatt, service, ENV_CHAR_UUID)
                 ENV_CHAR_UUID -> enableNotification(gatt, service, SND_CHAR_UUID)
-                SND_CHAR_UUID -> {
-                    Log.d("BLE_DEBUG", "All notifications active.")
-                    handler.post {
-                        listener?.onConnectionStateChanged(true, "🟢 Conectado")
+                SNAP_CHAR_UUID ->
+                    if (service.getCharacteristic(LOG_CHAR_UUID) != null) {
+                        enableNotification(gatt, service, LOG_CHAR_UUID)
+                    } else {
+                        onAllNotificationsEnabled(gatt)
                     }
-                }
+                SND_CHAR_UUID, LOG_CHAR_UUID -> onAllNotificationsEnabled(gatt)
+            }
+        }
+
+        private fun onAllNotificationsEnabled(gatt: BluetoothGatt) {
+            Log.d("BLE_DEBUG", "All notifications active.")
+            if (batchSize > 0) writeBatchSize(gatt)
+            handler.post {
+                listener?.onConnectionStateChanged(true, "🟢 Conectado")
             }
         }
 
@@ -190,6 +262,8 @@ class BluetoothManager(private val context: Context) {
                 GAS_CHAR_UUID -> parseGasPacket(characteristic.value)
                 ENV_CHAR_UUID -> parseEnvPacket(characteristic.value)
                 SND_CHAR_UUID -> parseSoundPacket(characteristic.value)
+                SNAP_CHAR_UUID -> parseSnapshotFrame(characteristic.value)
+                LOG_CHAR_UUID -> parseLogFrame(characteristic.value)
             }
         }
     }
@@ -213,13 +287,71 @@ class BluetoothManager(private val context: Context) {
         handler.post { listener?.onEnvDataUpdated(temp, hum) }
     }
 
+    // Sound window: start_ms u32, events u16, peak rate u16 (0.1/s), first_ms u16, last_ms u16
     private fun parseSoundPacket(data: ByteArray?) {
         if (data == null || data.size < 4) return
         val buffer = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN)
-        val count = buffer.int
+        val count = if (data.size >= 12) {
+            buffer.int // window start, not used yet
+            buffer.short.toInt() and 0xFFFF
+        } else {
+            buffer.int // legacy firmware: running counter
+        }
         handler.post { listener?.onSoundDetected(count) }
     }
 
+    // Snapshot v1: version u8, valid u8, seq u16, ts u32, 5 gases u16 (0.01 ppm),
+    // temp i16 (0.01 C), hum u16 (0.01 %), sound events u16
+    private fun parseSnapshotPacket(data: ByteArray, offset: Int = 0) {
+        if (data.size - offset < SNAPSHOT_LEN || data[offset].toInt() != 1) return
+        val buffer = ByteBuffer.wrap(data, offset, SNAPSHOT_LEN).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.get() // version
+        val valid = buffer.get().toInt() and 0xFF
+        buffer.short // sequence, not used yet
+        buffer.int // device timestamp, not used yet
+        val gases = FloatArray(5) { (buffer.short.toInt() and 0xFFFF) / 100f }
+        val temp = buffer.short / 100f
+        val hum = (buffer.short.toInt() and 0xFFFF) / 100f
+        val events = buffer.short.toInt() and 0xFFFF
+
+        handler.post {
+            if (valid and 0x1F != 0) {
+                listener?.onGasDataUpdated(gases[0], gases[1], gases[2], gases[3], gases[4])
+            }
+            if (valid and 0x60 == 0x60) listener?.onEnvDataUpdated(temp, hum)
+            if (valid and 0x80 != 0) listener?.onSoundDetected(events)
+        }
+    }
+
+    // Either one snapshot, or a batch: tag 0x81, count u8, count snapshots
+    private fun parseSnapshotFrame(data: ByteArray?) {
+        if (data == null || data.isEmpty()) return
+        if ((data[0].toInt() and 0xFF) != SNAPSHOT_BATCH_TAG) {
+            parseSnapshotPacket(data)
+            return
+        }
+        if (data.size < 2) return
+        val count = data[1].toInt() and 0xFF
+        for (i in 0 until count) {
+            parseSnapshotPacket(data, 2 + i * SNAPSHOT_LEN)
+        }
+    }
+
+    // Flash log frame: end marker (u8 0, u32 next seq) or a log block
+    private fun parseLogFrame(data: ByteArray?) {
+        if (data == null || data.isEmpty()) return
+        if (data[0].toInt() == 0) {
+            if (data.size < 5) return
+            val next = ByteBuffer.wrap(data, 1, 4).order(ByteOrder.LITTLE_ENDIAN).int.toLong() and 0xFFFFFFFFL
+            handler.post { listener?.onBacklogComplete(next) }
+            return
+        }
+        val records = SampleLogDecoder.decodeBlock(data)
+        handler.post {
+            records.forEach { listener?.onBacklogRecord(it.seq, it.boot, it.timestampMs, it.kind, it.values) }
+        }
+    }
+
     fun isConnected() = isConnected
     fun cleanup() { stopScan(); disconnect() }
 }
@@ -0,0 +1,110 @@
+package com.example.roommonitorapp
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Decodes flash log blocks streamed by the firmware's log characteristic
+ * (see sample_store.h and sample_codec.h in the firmware).
+ *
+ * Header: version u8, count u8, boot u16, first seq u32, base ts u32.
+ * Version 1 records: kind u8, dt u16, fixed-width payload.
+ * Version 2 records: kind u8, varint dt from the previous record, then one
+ * zigzag varint delta per field against the previous record of that kind.
+ */
+object SampleLogDecoder {
+
+    // Sample kinds, as in the firmware's enum sample_kind
+    const val KIND_GAS = 0
+    const val KIND_ENV = 1
+    const val KIND_SOUND = 2
+    const val KIND_SOUND_LEVEL = 3
+
+    private const val HDR_LEN = 12
+    private val FIELDS = intArrayOf(6, 2, 4, 3)
+
+    /**
+     * values: gas ppm x5 (KIND_GAS), temp/hum (KIND_ENV),
+     * events/peak rate/first/last ms (KIND_SOUND), rms/peak/dBFS (KIND_SOUND_LEVEL).
+     * timestampMs counts from boot number [boot] of the device.
+     */
+    class Record(val seq: Long, val boot: Int, val timestampMs: Long, val kind: Int, val values: FloatArray)
+
+    /** Records of one block; empty for unknown versions, truncated at the first bad record. */
+    fun decodeBlock(data: ByteArray): List<Record> {
+        if (data.size < HDR_LEN) return emptyList()
+        val buffer = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN)
+        val version = buffer.get().toInt() and 0xFF
+        val count = buffer.get().toInt() and 0xFF
+        val boot = buffer.short.toInt() and 0xFFFF
+        val seq = buffer.int.toLong() and 0xFFFFFFFFL
+        val base = buffer.int.toLong() and 0xFFFFFFFFL
+
+        return when (version) {
+            1 -> decodeFixed(buffer, count, boot, seq, base)
+            2 -> decodePacked(buffer, count, boot, seq, base)
+            else -> emptyList()
+        }
+    }
+
+    private fun decodeFixed(buffer: ByteBuffer, count: Int, boot: Int, seq: Long, base: Long): List<Record> {
+        val out = ArrayList<Record>(count)
+        fun u16() = (buffer.short.toInt() and 0xFFFF).toFloat()
+
+        for (i in 0 until count) {
+            if (buffer.remaining() < 3) break
+            val kind = buffer.get().toInt() and 0xFF
+            val ts = base + (buffer.short.toInt() and 0xFFFF)
+            val values = when (kind) {
+                KIND_GAS -> {
+                    buffer.get() // valid mask
+                    FloatArray(5) { u16() / 100f }
+                }
+                KIND_ENV -> floatArrayOf(buffer.short / 100f, u16() / 100f)
+                KIND_SOUND -> FloatArray(4) { u16() }
+                KIND_SOUND_LEVEL -> floatArrayOf(u16(), u16(), buffer.short / 100f)
+                else -> break // the rest of the block can't be framed
+            }
+            out.add(Record(seq + i, boot, ts, kind, values))
+        }
+        return out
+    }
+
+    private fun decodePacked(buffer: ByteBuffer, count: Int, boot: Int, seq: Long, base: Long): List<Record> {
+        val out = ArrayList<Record>(count)
+        val prev = Array(FIELDS.size) { IntArray(6) }
+        var ts = base
+
+        fun varint(): Long? {
+            var v = 0L
+            var shift = 0
+            while (buffer.hasRemaining() && shift < 35) {
+                val b = buffer.get().toInt() and 0xFF
+                v = v or ((b and 0x7F).toLong() shl shift)
+                if (b and 0x80 == 0) return v
+                shift += 7
+            }
+            return null
+        }
+
+        for (i in 0 until count) {
+            if (!buffer.hasRemaining()) break
+            val kind = buffer.get().toInt() and 0xFF
+            if (kind >= FIELDS.size) break
+            ts += varint() ?: break
+            val p = prev[kind]
+            for (f in 0 until FIELDS[kind]) {
+                val z = varint() ?: return out
+                p[f] += ((z ushr 1) xor -(z and 1)).toInt()
+            }
+            val values = when (kind) {
+                KIND_GAS -> FloatArray(5) { p[it + 1] / 100f } // p[0] is the valid mask
+                KIND_ENV -> floatArrayOf(p[0] / 100f, p[1] / 100f)
+                KIND_SOUND -> FloatArray(4) { p[it].toFloat() }
+                else -> floatArrayOf(p[0].toFloat(), p[1].toFloat(), p[2] / 100f)
+            }
+            out.add(Record(seq + i, boot, ts and 0xFFFFFFFFL, kind, values))
+        }
+        return out
+    }
+}
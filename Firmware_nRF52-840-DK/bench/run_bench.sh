@@ -0,0 +1,80 @@
+#!/usr/bin/env bash
+# Per-sample micro-benchmarks on the host (native_posix) and under QEMU
+# (qemu_cortex_m3): builds the ztest image of overlay-bench.conf, runs it
+# until ztest reports and keeps the CSV lines. Needs ZEPHYR_BASE and west.
+#
+# Results: $BENCH_OUT/<board>.csv. Fails when a test case fails (per-sample
+# budget, ring stress, codec round trip, store replay) or, with
+# BENCH_BASELINE=<dir of earlier results>, when a benchmark's average got
+# more than BENCH_TOLERANCE_PCT slower.
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+app=$(dirname "$here")
+out=${BENCH_OUT:-$here/out}
+boards=${BENCH_BOARDS:-native_posix qemu_cortex_m3}
+tolerance=${BENCH_TOLERANCE_PCT:-20}
+timeout_s=${BENCH_TIMEOUT_S:-120}
+
+: "${ZEPHYR_BASE:?}"
+
+# Runs the build until the ztest summary shows up in the log, then stops it
+run_board() {
+    local board=$1 build=$out/$1 log=$out/$1.log
+
+    west build -p auto -b "$board" -d "$build" "$app/zephyr" -- \
+        -DOVERLAY_CONFIG=overlay-bench.conf
+    if [ "$board" = native_posix ]; then
+        "$build/zephyr/zephyr.exe" > "$log" 2>&1 &
+    else
+        west build -d "$build" -t run > "$log" 2>&1 &
+    fi
+    local pid=$!
+
+    for _ in $(seq "$timeout_s"); do
+        grep -q 'PROJECT EXECUTION' "$log" && break
+        sleep 1
+    done
+    pkill -P "$pid" 2> /dev/null || true
+    kill "$pid" 2> /dev/null || true
+    wait "$pid" 2> /dev/null || true
+
+    if ! grep -q 'PROJECT EXECUTION' "$log"; then
+        echo "$board: no test summary within ${timeout_s}s" >&2
+        return 1
+    fi
+    grep -oE '(BENCH|STRESS|CODEC|BUDGET),.*' "$log" > "$out/$board.csv"
+}
+
+# BENCH,<name>,<iterations>,<min>,<avg>,<max>,<avg ns>: compares avg ns
+compare() {
+    local board=$1 base=$BENCH_BASELINE/$1.csv
+
+    [ -f "$base" ] || return 0
+    awk -F, -v tol="$tolerance" -v board="$board" '
+        NR == FNR { if ($1 == "BENCH" && NF == 7) base[$2] = $7; next }
+        $1 == "BENCH" && NF == 7 && ($2 in base) && base[$2] > 0 {
+            pct = ($7 - base[$2]) * 100 / base[$2]
+            if (pct > tol) {
+                printf "%s: %s %d ns -> %d ns (+%d%%)\n", board, $2, base[$2], $7, pct
+                bad = 1
+            }
+        }
+        END { exit bad }' "$base" "$out/$board.csv"
+}
+
+mkdir -p "$out"
+status=0
+for board in $boards; do
+    run_board "$board" || { status=1; continue; }
+    cat "$out/$board.csv"
+    if ! grep -q 'PROJECT EXECUTION SUCCESSFUL' "$out/$board.log"; then
+        grep -E '(FAIL|Assertion failed)' "$out/$board.log" >&2 || true
+        echo "$board: test cases failed" >&2
+        status=1
+    fi
+    if [ -n "${BENCH_BASELINE:-}" ]; then
+        compare "$board" || status=1
+    fi
+done
+exit $status
@@ -0,0 +1,331 @@
+/* main.c - Scripted central for the BabbleSim throughput/latency bench
+ *
+ * Connects to the SomnoSense peripheral once per transport mode, lets it
+ * stream for BENCH_MODE_MS and prints one CSV line per mode:
+ *
+ *   BSIM,mode,notifications,records,bytes,duration_ms,notif_per_s,
+ *        bytes_per_event,lat_p50,lat_p90,lat_p99,lat_max,reconnect_ms
+ *
+ * Both devices run on the simulated clock from the same instant, so the
+ * device timestamp in every snapshot record gives the sample-to-notify
+ * latency directly. reconnect_ms runs from the previous disconnection
+ * (boot for the first mode) to the first notification of the mode, so it
+ * covers scanning, connection, MTU exchange, discovery and subscription.
+ */
+
+#include <zephyr.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/hci.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/uuid.h>
+#include <sys/byteorder.h>
+#include <sys/printk.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+#define BENCH_MODE_MS   20000
+#define BENCH_STEP_MS   10000  /* timeout of every setup step */
+#define BENCH_BATCH     SNAPSHOT_BATCH_MAX
+#define LAT_MAX_SAMPLES 1024
+
+/* Same values as ble_manager.c */
+#define BT_UUID_GAS_SERVICE_VAL BT_UUID_128_ENCODE(0x47617353, 0x656e, 0x736f, 0x7253, 0x766300000000)
+#define BT_UUID_GAS_CHAR_VAL    BT_UUID_128_ENCODE(0x47617352, 0x6561, 0x6469, 0x6e67, 0x730000000000)
+#define BT_UUID_ENV_CHAR_VAL    BT_UUID_128_ENCODE(0x456e7669, 0x726f, 0x6e6d, 0x656e, 0x740000000000)
+#define BT_UUID_SND_CHAR_VAL    BT_UUID_128_ENCODE(0x536f756e, 0x6444, 0x6574, 0x6563, 0x740000000000)
+#define BT_UUID_SNAP_CHAR_VAL   BT_UUID_128_ENCODE(0x536e6170, 0x7368, 0x6f74, 0x5631, 0x000000000000)
+#define BT_UUID_MODE_CHAR_VAL   BT_UUID_128_ENCODE(0x4e6f7469, 0x6679, 0x4d6f, 0x6465, 0x000000000000)
+
+static struct bt_uuid_128 service_uuid = BT_UUID_INIT_128(BT_UUID_GAS_SERVICE_VAL);
+
+enum bench_mode {
+    MODE_LIVE,    /* one snapshot per notification */
+    MODE_BATCH,   /* BENCH_BATCH snapshots per notification */
+    MODE_LEGACY,  /* per-sensor float characteristics */
+    MODE_COUNT
+};
+
+static const char *const mode_names[MODE_COUNT] = { "live", "batch", "legacy" };
+
+enum bench_chrc {
+    CHRC_SNAP,
+    CHRC_MODE,
+    CHRC_GAS,
+    CHRC_ENV,
+    CHRC_SND,
+    CHRC_COUNT
+};
+
+static const struct bt_uuid_128 chrc_uuids[CHRC_COUNT] = {
+    [CHRC_SNAP] = BT_UUID_INIT_128(BT_UUID_SNAP_CHAR_VAL),
+    [CHRC_MODE] = BT_UUID_INIT_128(BT_UUID_MODE_CHAR_VAL),
+    [CHRC_GAS] = BT_UUID_INIT_128(BT_UUID_GAS_CHAR_VAL),
+    [CHRC_ENV] = BT_UUID_INIT_128(BT_UUID_ENV_CHAR_VAL),
+    [CHRC_SND] = BT_UUID_INIT_128(BT_UUID_SND_CHAR_VAL),
+};
+
+static uint16_t handles[CHRC_COUNT];
+
+/* Written from the BT RX thread while a mode runs, read by main after
+ * the connection is gone
+ */
+static struct {
+    uint32_t notifications;
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t first_ms;
+    uint32_t lat_count;
+    uint16_t lat[LAT_MAX_SAMPLES];
+} stats;
+
+static struct bt_conn *conn;
+static uint32_t disconnected_ms;
+static uint8_t att_err;
+
+static K_SEM_DEFINE(connected_sem, 0, 1);
+static K_SEM_DEFINE(disconnected_sem, 0, 1);
+static K_SEM_DEFINE(step_sem, 0, 1);
+static K_SEM_DEFINE(first_rx_sem, 0, 1);
+
+static bool ad_has_service(struct bt_data *data, void *user_data) {
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_UUID128_ALL && data->data_len == sizeof(service_uuid.val) &&
+        !memcmp(data->data, service_uuid.val, sizeof(service_uuid.val))) {
+        *found = true;
+        return false;
+    }
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type, struct net_buf_simple *ad) {
+    bool found = false;
+
+    if (conn || type != BT_GAP_ADV_TYPE_ADV_IND) return;
+
+    bt_data_parse(ad, ad_has_service, &found);
+    if (!found || bt_le_scan_stop()) return;
+
+    int err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT, &conn);
+    if (err) printk("Create connection failed (err %d)\n", err);
+}
+
+static void connected(struct bt_conn *c, uint8_t err) {
+    if (err) {
+        printk("Connection failed (err %u)\n", err);
+        bt_conn_unref(conn);
+        conn = NULL;
+        bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+        return;
+    }
+    k_sem_give(&connected_sem);
+}
+
+static void disconnected(struct bt_conn *c, uint8_t reason) {
+    disconnected_ms = k_uptime_get_32();
+    bt_conn_unref(conn);
+    conn = NULL;
+    k_sem_give(&disconnected_sem);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+static void mtu_done(struct bt_conn *c, uint8_t err, struct bt_gatt_exchange_params *params) {
+    att_err = err;
+    k_sem_give(&step_sem);
+}
+
+static uint8_t discover_func(struct bt_conn *c, const struct bt_gatt_attr *attr, struct bt_gatt_discover_params *params) {
+    if (!attr) {
+        k_sem_give(&step_sem);
+        return BT_GATT_ITER_STOP;
+    }
+
+    const struct bt_gatt_chrc *chrc = attr->user_data;
+
+    for (int i = 0; i < CHRC_COUNT; i++) {
+        if (!bt_uuid_cmp(chrc->uuid, &chrc_uuids[i].uuid)) {
+            handles[i] = chrc->value_handle;
+        }
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static void write_done(struct bt_conn *c, uint8_t err, struct bt_gatt_write_params *params) {
+    att_err = err;
+    k_sem_give(&step_sem);
+}
+
+static void add_latency(uint32_t now, const uint8_t *record) {
+    uint32_t lat = now - sys_get_le32(&record[4]);
+
+    if (stats.lat_count < LAT_MAX_SAMPLES) {
+        stats.lat[stats.lat_count++] = MIN(lat, UINT16_MAX);
+    }
+}
+
+static uint8_t notify_func(struct bt_conn *c, struct bt_gatt_subscribe_params *params, const void *data, uint16_t length) {
+    const uint8_t *buf = data;
+    uint32_t now = k_uptime_get_32();
+
+    if (!data) {
+        params->value_handle = 0;
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (!stats.notifications++) {
+        stats.first_ms = now;
+        k_sem_give(&first_rx_sem);
+    }
+    stats.bytes += length;
+
+    if (params->value_handle != handles[CHRC_SNAP]) {
+        stats.records++;  /* legacy payloads carry no timestamp */
+    } else if (length >= SNAPSHOT_BATCH_LEN(1) && buf[0] == SNAPSHOT_BATCH_TAG) {
+        for (uint8_t i = 0; i < buf[1] && SNAPSHOT_BATCH_LEN(i + 1) <= length; i++) {
+            add_latency(now, &buf[SNAPSHOT_BATCH_LEN(i)]);
+            stats.records++;
+        }
+    } else if (length == SNAPSHOT_LEN) {
+        add_latency(now, buf);
+        stats.records++;
+    }
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static int cmp_u16(const void *a, const void *b) {
+    return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+static uint16_t percentile(uint32_t pct) {
+    return stats.lat_count ? stats.lat[(stats.lat_count - 1) * pct / 100] : 0;
+}
+
+static int wait_step(struct k_sem *sem, const char *what) {
+    if (k_sem_take(sem, K_MSEC(BENCH_STEP_MS))) {
+        printk("Bench step timed out: %s\n", what);
+        return -ETIMEDOUT;
+    }
+    if (sem == &step_sem && att_err) {
+        printk("Bench step failed: %s (att err 0x%02x)\n", what, att_err);
+        return -EIO;
+    }
+    return 0;
+}
+
+static int run_mode(enum bench_mode mode, uint32_t since_ms) {
+    static struct bt_gatt_exchange_params mtu_params = { .func = mtu_done };
+    static struct bt_gatt_discover_params disc_params;
+    static struct bt_gatt_write_params write_params;
+    static struct bt_gatt_subscribe_params subs[3];
+    uint8_t batch = mode == MODE_BATCH ? BENCH_BATCH : 0;
+    struct bt_conn_info info;
+    int err;
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err) return err;
+    err = wait_step(&connected_sem, "connect");
+    if (err) return err;
+
+    err = bt_gatt_exchange_mtu(conn, &mtu_params);
+    if (!err) err = wait_step(&step_sem, "mtu");
+    if (err) return err;
+
+    memset(handles, 0, sizeof(handles));
+    disc_params = (struct bt_gatt_discover_params) {
+        .func = discover_func,
+        .start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE,
+        .end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE,
+        .type = BT_GATT_DISCOVER_CHARACTERISTIC,
+    };
+    err = bt_gatt_discover(conn, &disc_params);
+    if (!err) err = wait_step(&step_sem, "discover");
+    if (err) return err;
+
+    write_params = (struct bt_gatt_write_params) {
+        .func = write_done,
+        .handle = handles[CHRC_MODE],
+        .data = &batch,
+        .length = sizeof(batch),
+    };
+    err = bt_gatt_write(conn, &write_params);
+    if (!err) err = wait_step(&step_sem, "mode");
+    if (err) return err;
+
+    memset(&stats, 0, sizeof(stats));
+    k_sem_reset(&first_rx_sem);
+
+    const enum bench_chrc sub_chrcs[] = { CHRC_GAS, CHRC_ENV, CHRC_SND };
+    int sub_count = mode == MODE_LEGACY ? ARRAY_SIZE(sub_chrcs) : 1;
+
+    for (int i = 0; i < sub_count; i++) {
+        uint16_t handle = handles[mode == MODE_LEGACY ? sub_chrcs[i] : CHRC_SNAP];
+
+        if (!handle) {
+            printk("Characteristic missing for mode %s\n", mode_names[mode]);
+            return -ENOENT;
+        }
+        subs[i] = (struct bt_gatt_subscribe_params) {
+            .notify = notify_func,
+            .value_handle = handle,
+            .ccc_handle = handle + 1,  /* CCC right after the value */
+            .value = BT_GATT_CCC_NOTIFY,
+        };
+        err = bt_gatt_subscribe(conn, &subs[i]);
+        if (err) return err;
+    }
+
+    err = wait_step(&first_rx_sem, "first notification");
+    if (err) return err;
+    k_sleep(K_MSEC(BENCH_MODE_MS));
+
+    bt_conn_get_info(conn, &info);
+    uint32_t interval_us = info.le.interval * 1250;
+
+    bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    err = wait_step(&disconnected_sem, "disconnect");
+    if (err) return err;
+
+    /* Everything below reads stats after the link is gone */
+    uint32_t duration_ms = disconnected_ms - stats.first_ms;
+    uint32_t events = MAX(1, (uint32_t)((uint64_t)duration_ms * 1000 / interval_us));
+
+    qsort(stats.lat, stats.lat_count, sizeof(stats.lat[0]), cmp_u16);
+    printk("BSIM,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", mode_names[mode],
+           stats.notifications, stats.records, stats.bytes, duration_ms,
+           stats.notifications * 1000 / MAX(duration_ms, 1), stats.bytes / events,
+           percentile(50), percentile(90), percentile(99), percentile(100),
+           stats.first_ms - since_ms);
+    return 0;
+}
+
+void main(void) {
+    uint32_t since_ms;
+    int err;
+
+    err = bt_enable(NULL);
+    if (err) {
+        printk("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    printk("BSIM,mode,notifications,records,bytes,duration_ms,notif_per_s,"
+           "bytes_per_event,lat_p50,lat_p90,lat_p99,lat_max,reconnect_ms\n");
+
+    since_ms = k_uptime_get_32();
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        err = run_mode(mode, since_ms);
+        if (err) {
+            printk("BSIM,%s,failed,%d\n", mode_names[mode], err);
+            return;
+        }
+        since_ms = disconnected_ms;
+    }
+    printk("BSIM,done\n");
+}
@@ -0,0 +1,372 @@
+/* main.c - Provisioner and Sensor Client for the BabbleSim mesh bench
+ *
+ * Creates the network, provisions CONFIG_MESH_CLIENT_NODES SomnoSense
+ * Sensor Servers over PB-ADV, points their Sensor Status publication at
+ * the group this client subscribes to, and then checks what arrives for
+ * CONFIG_MESH_CLIENT_OBSERVE_S. Every Sensor Status is parsed as
+ * marshalled sensor data; properties must be ones the firmware publishes
+ * and values must be in range. One CSV line per node, then the verdict:
+ *
+ *   MESH,node,addr,published,get_replies,properties,invalid,first_pub_ms
+ *   MESH,done,<pass|fail>
+ *
+ * first_pub_ms is the client uptime at the node's first group publication
+ * (0 if none). A node passes with at least OBSERVE / PUB_PERIOD - 1 group
+ * publications, a reply to a unicast Sensor Get, temperature, humidity
+ * and VOC all reported with a known value, and nothing invalid.
+ */
+
+#include <zephyr.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+#include <sys/byteorder.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include "mesh_sensor.h"
+
+#define OP_SENSOR_GET    BT_MESH_MODEL_OP_2(0x82, 0x31)
+#define OP_SENSOR_STATUS BT_MESH_MODEL_OP_1(0x52)
+
+#define NET_IDX         0
+#define APP_IDX         0
+#define SELF_ADDR       0x0001
+#define GROUP_ADDR      0xc000  /* APP_MESH_GROUP_ADDR default */
+#define PROV_TIMEOUT_MS 60000   /* per node, beacon to node_added */
+#define CFG_TIMEOUT_MS  5000
+#define GET_TIMEOUT_MS  5000
+
+#define NODES CONFIG_MESH_CLIENT_NODES
+
+/* Device UUID prefix of mesh_sensor.c */
+static const uint8_t uuid_prefix[8] = { 'S', 'o', 'm', 'n', 'o', 'S', 'n', 's' };
+
+/* Fixed test keys, as in mesh_sensor.c self-provisioning. Never ship them. */
+static const uint8_t net_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x4e, 0x65, 0x74, 0x4b, 0x65, 0x79 };
+static const uint8_t dev_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x44, 0x65, 0x76, 0x4b, 0x65, 0x79 };
+static const uint8_t app_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x41, 0x70, 0x70, 0x4b, 0x65, 0x79 };
+
+enum {
+    SEEN_TEMP = BIT(0),
+    SEEN_HUM = BIT(1),
+    SEEN_VOC = BIT(2),
+    SEEN_NOISE = BIT(3),
+};
+
+#define SEEN_REQUIRED (SEEN_TEMP | SEEN_HUM | SEEN_VOC)
+
+/* Written from the BT RX thread, read by main after the observe window */
+struct node {
+    uint8_t uuid[16];
+    uint16_t addr;
+    uint32_t published;    /* Sensor Status to the group */
+    uint32_t get_replies;  /* Sensor Status to us */
+    uint8_t seen;          /* SEEN_* with a known value */
+    uint32_t invalid;
+    uint32_t first_pub_ms;
+};
+
+static struct node nodes[NODES];
+static uint32_t node_count;
+static uint32_t stray;
+
+static uint8_t beacon_uuid[16];
+static uint16_t added_addr;
+
+static K_SEM_DEFINE(beacon_sem, 0, 1);
+static K_SEM_DEFINE(added_sem, 0, 1);
+static K_SEM_DEFINE(get_sem, 0, 1);
+
+static struct node *find_node(uint16_t addr) {
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (nodes[i].addr == addr) return &nodes[i];
+    }
+    return NULL;
+}
+
+/* Range of every property mesh_sensor.c publishes; unknown values count
+ * as valid but not as seen
+ */
+static bool check_value(struct node *n, uint16_t id, uint8_t len, int32_t v) {
+    switch (id) {
+    case MESH_PROP_PRESENT_AMB_TEMP:
+        if (len != 1) return false;
+        /* sint8 in 0.5 C: every value is in range */
+        if (v != 0x7f) n->seen |= SEEN_TEMP;
+        return true;
+    case MESH_PROP_PRESENT_AMB_REL_HUMIDITY:
+        if (len != 2) return false;
+        if (v == 0xffff) return true;
+        n->seen |= SEEN_HUM;
+        return v <= 10000;
+    case MESH_PROP_PRESENT_AMB_VOC_CONC:
+        if (len != 2) return false;
+        if (v != 0xffff) n->seen |= SEEN_VOC;
+        return true;
+    case MESH_PROP_PRESENT_AMB_NOISE:
+        if (len != 1) return false;
+        if (v == 0xff) return true;
+        n->seen |= SEEN_NOISE;
+        return v <= 254;
+    default:
+        return false;
+    }
+}
+
+/* Marshalled Sensor Data: format A (1 bit format, 4 bits length - 1,
+ * 11 bits ID) or format B (1 bit format, 7 bits length - 1, 16 bits ID)
+ */
+static bool parse_status(struct node *n, struct net_buf_simple *buf) {
+    if (!buf->len) return false;
+
+    while (buf->len) {
+        uint8_t hdr = buf->data[0];
+        uint16_t id;
+        uint8_t len;
+
+        if (!(hdr & 1)) {
+            if (buf->len < 2) return false;
+            uint16_t a = net_buf_simple_pull_le16(buf);
+
+            len = ((a >> 1) & 0xf) + 1;
+            id = a >> 5;
+        } else {
+            if (buf->len < 3) return false;
+            net_buf_simple_pull_u8(buf);
+            id = net_buf_simple_pull_le16(buf);
+            /* 0x7f: no value, the property is not supported */
+            if ((hdr >> 1) == 0x7f) return false;
+            len = (hdr >> 1) + 1;
+        }
+
+        if (len > 2 || buf->len < len) return false;
+
+        int32_t v = len == 1 ? net_buf_simple_pull_u8(buf) : net_buf_simple_pull_le16(buf);
+
+        if (!check_value(n, id, len, v)) return false;
+    }
+    return true;
+}
+
+static int sensor_status(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    struct node *n = find_node(ctx->addr);
+
+    if (!n) {
+        stray++;
+        return 0;
+    }
+
+    if (!parse_status(n, buf)) {
+        n->invalid++;
+    }
+
+    if (ctx->recv_dst == GROUP_ADDR) {
+        if (!n->published++) n->first_pub_ms = k_uptime_get_32();
+    } else {
+        n->get_replies++;
+        k_sem_give(&get_sem);
+    }
+    return 0;
+}
+
+static const struct bt_mesh_model_op sensor_cli_op[] = {
+    { OP_SENSOR_STATUS, BT_MESH_LEN_MIN(0), sensor_status },
+    BT_MESH_MODEL_OP_END,
+};
+
+static struct bt_mesh_cfg_cli cfg_cli;
+
+static struct bt_mesh_model root_models[] = {
+    BT_MESH_MODEL_CFG_SRV,
+    BT_MESH_MODEL_CFG_CLI(&cfg_cli),
+    BT_MESH_MODEL(BT_MESH_MODEL_ID_SENSOR_CLI, sensor_cli_op, NULL, NULL),
+};
+
+static struct bt_mesh_elem elements[] = {
+    BT_MESH_ELEM(0, root_models, BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+    .cid = BT_COMP_ID_LF,
+    .elem = elements,
+    .elem_count = ARRAY_SIZE(elements),
+};
+
+static struct bt_mesh_model *cli_model;
+static uint8_t dev_uuid[16] = { 'S', 'o', 'm', 'n', 'o', 'C', 'l', 'i' };
+
+/* Only SomnoSense nodes not taken yet, one at a time: the next beacon is
+ * taken after the current node is added
+ */
+static void unprovisioned_beacon(uint8_t uuid[16], bt_mesh_prov_oob_info_t oob_info, uint32_t *uri_hash) {
+    if (memcmp(uuid, uuid_prefix, sizeof(uuid_prefix)) || k_sem_count_get(&beacon_sem)) return;
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (!memcmp(uuid, nodes[i].uuid, sizeof(nodes[i].uuid))) return;
+    }
+
+    memcpy(beacon_uuid, uuid, sizeof(beacon_uuid));
+    k_sem_give(&beacon_sem);
+}
+
+static void node_added(uint16_t net_idx, uint8_t uuid[16], uint16_t addr, uint8_t num_elem) {
+    added_addr = addr;
+    k_sem_give(&added_sem);
+}
+
+static const struct bt_mesh_prov prov = {
+    .uuid = dev_uuid,
+    .unprovisioned_beacon = unprovisioned_beacon,
+    .node_added = node_added,
+};
+
+static int setup_self(void) {
+    struct bt_mesh_cdb_app_key *key;
+    uint8_t status;
+    int err;
+
+    err = bt_mesh_cdb_create(net_key);
+    if (err) return err;
+
+    key = bt_mesh_cdb_app_key_alloc(NET_IDX, APP_IDX);
+    if (!key) return -ENOMEM;
+    memcpy(key->keys[0].app_key, app_key, sizeof(app_key));
+
+    err = bt_mesh_provision(net_key, NET_IDX, 0, 0, SELF_ADDR, dev_key);
+    if (err) return err;
+
+    err = bt_mesh_cfg_app_key_add(NET_IDX, SELF_ADDR, NET_IDX, APP_IDX, app_key, &status);
+    if (err || status) return err ? err : -EIO;
+    err = bt_mesh_cfg_mod_app_bind(NET_IDX, SELF_ADDR, SELF_ADDR, APP_IDX,
+                                   BT_MESH_MODEL_ID_SENSOR_CLI, &status);
+    if (err || status) return err ? err : -EIO;
+    err = bt_mesh_cfg_mod_sub_add(NET_IDX, SELF_ADDR, SELF_ADDR, GROUP_ADDR,
+                                  BT_MESH_MODEL_ID_SENSOR_CLI, &status);
+    return err ? err : (status ? -EIO : 0);
+}
+
+/* The same setup mesh_sensor.c does for itself under APP_MESH_SELF_PROV,
+ * at a bench-sized period
+ */
+static int configure_node(uint16_t addr) {
+    struct bt_mesh_cfg_mod_pub pub = {
+        .addr = GROUP_ADDR,
+        .app_idx = APP_IDX,
+        .ttl = BT_MESH_TTL_DEFAULT,
+        .period = BT_MESH_PUB_PERIOD_SEC(CONFIG_MESH_CLIENT_PUB_PERIOD_S),
+        .transmit = BT_MESH_TRANSMIT(1, 20),
+    };
+    uint8_t status;
+    int err;
+
+    err = bt_mesh_cfg_app_key_add(NET_IDX, addr, NET_IDX, APP_IDX, app_key, &status);
+    if (err || status) return err ? err : -EIO;
+    err = bt_mesh_cfg_mod_app_bind(NET_IDX, addr, addr, APP_IDX, BT_MESH_MODEL_ID_SENSOR_SRV,
+                                   &status);
+    if (err || status) return err ? err : -EIO;
+    err = bt_mesh_cfg_mod_app_bind(NET_IDX, addr, addr, APP_IDX,
+                                   BT_MESH_MODEL_ID_SENSOR_SETUP_SRV, &status);
+    if (err || status) return err ? err : -EIO;
+    err = bt_mesh_cfg_mod_pub_set(NET_IDX, addr, addr, BT_MESH_MODEL_ID_SENSOR_SRV, &pub,
+                                  &status);
+    return err ? err : (status ? -EIO : 0);
+}
+
+static int provision_nodes(void) {
+    while (node_count < NODES) {
+        int err;
+
+        if (k_sem_take(&beacon_sem, K_MSEC(PROV_TIMEOUT_MS))) {
+            printk("No unprovisioned node after %u of %u\n", node_count, NODES);
+            return -ETIMEDOUT;
+        }
+
+        err = bt_mesh_provision_adv(beacon_uuid, NET_IDX, 0, 0);
+        if (err) {
+            printk("Provisioning start failed (err %d)\n", err);
+            continue;
+        }
+        if (k_sem_take(&added_sem, K_MSEC(PROV_TIMEOUT_MS))) {
+            printk("Provisioning timed out\n");
+            continue;
+        }
+
+        err = configure_node(added_addr);
+        if (err) {
+            printk("Node 0x%04x configuration failed (err %d)\n", added_addr, err);
+            return err;
+        }
+        printk("Node 0x%04x provisioned and configured\n", added_addr);
+        memcpy(nodes[node_count].uuid, beacon_uuid, sizeof(beacon_uuid));
+        nodes[node_count++].addr = added_addr;
+        k_sem_reset(&beacon_sem);
+    }
+    return 0;
+}
+
+static int sensor_get(struct node *n) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_GET, 0);
+    struct bt_mesh_msg_ctx ctx = {
+        .net_idx = NET_IDX,
+        .app_idx = APP_IDX,
+        .addr = n->addr,
+        .send_ttl = BT_MESH_TTL_DEFAULT,
+    };
+    int err;
+
+    k_sem_reset(&get_sem);
+    bt_mesh_model_msg_init(&msg, OP_SENSOR_GET);
+    err = bt_mesh_model_send(cli_model, &ctx, &msg, NULL, NULL);
+    if (err) return err;
+    return k_sem_take(&get_sem, K_MSEC(GET_TIMEOUT_MS)) ? -ETIMEDOUT : 0;
+}
+
+void main(void) {
+    uint32_t min_pubs = MAX(CONFIG_MESH_CLIENT_OBSERVE_S / CONFIG_MESH_CLIENT_PUB_PERIOD_S, 2) - 1;
+    uint32_t start_ms;
+    bool pass = true;
+    int err;
+
+    err = bt_enable(NULL);
+    if (!err) err = bt_mesh_init(&prov, &comp);
+    if (err) {
+        printk("Bluetooth init failed (err %d)\n", err);
+        printk("MESH,done,fail\n");
+        return;
+    }
+
+    cli_model = bt_mesh_model_find(&elements[0], BT_MESH_MODEL_ID_SENSOR_CLI);
+    bt_mesh_cfg_cli_timeout_set(CFG_TIMEOUT_MS);
+    err = setup_self();
+    if (!err) err = provision_nodes();
+    if (err) {
+        printk("MESH,setup,failed,%d\n", err);
+        printk("MESH,done,fail\n");
+        return;
+    }
+
+    start_ms = k_uptime_get_32();
+    for (uint32_t i = 0; i < node_count; i++) {
+        err = sensor_get(&nodes[i]);
+        if (err) printk("Sensor Get to 0x%04x failed (err %d)\n", nodes[i].addr, err);
+    }
+    k_sleep(K_TIMEOUT_ABS_MS(start_ms + CONFIG_MESH_CLIENT_OBSERVE_S * 1000));
+
+    printk("MESH,node,addr,published,get_replies,properties,invalid,first_pub_ms\n");
+    for (uint32_t i = 0; i < node_count; i++) {
+        const struct node *n = &nodes[i];
+
+        printk("MESH,node,0x%04x,%u,%u,0x%02x,%u,%u\n", n->addr, n->published,
+               n->get_replies, n->seen, n->invalid, n->first_pub_ms);
+        if (n->published < min_pubs || !n->get_replies || n->invalid ||
+            (n->seen & SEEN_REQUIRED) != SEEN_REQUIRED) {
+            pass = false;
+        }
+    }
+    if (stray) {
+        printk("MESH,stray,%u\n", stray);
+    }
+    printk("MESH,done,%s\n", pass ? "pass" : "fail");
+}
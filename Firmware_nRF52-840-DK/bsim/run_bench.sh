@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+# Two-device BabbleSim bench: the firmware (zephyr/, nrf52_bsim board
+# config) as peripheral and the scripted central in bsim/central, both on
+# one simulated 2.4 GHz channel. Runs headless; needs ZEPHYR_BASE and
+# BSIM_OUT_PATH set up as for Zephyr's own bsim tests, and west.
+#
+# Results: $BENCH_OUT/results.csv, one line per transport mode.
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+app=$(dirname "$here")
+out=${BENCH_OUT:-$here/out}
+sim_id=${SIM_ID:-somnosense_bench}
+# Three 20 s modes plus connection setup, with margin
+sim_length_us=${SIM_LENGTH_US:-120000000}
+
+: "${ZEPHYR_BASE:?}" "${BSIM_OUT_PATH:?}"
+
+west build -p auto -b nrf52_bsim -d "$out/peripheral" "$app/zephyr"
+west build -p auto -b nrf52_bsim -d "$out/central" "$here/central"
+
+mkdir -p "$out"
+(cd "$BSIM_OUT_PATH/bin" &&
+    ./bs_2G4_phy_v1 -s="$sim_id" -D=2 -sim_length="$sim_length_us") &
+"$out/peripheral/zephyr/zephyr.exe" -s="$sim_id" -d=0 > "$out/peripheral.log" 2>&1 &
+"$out/central/zephyr/zephyr.exe" -s="$sim_id" -d=1 > "$out/central.log" 2>&1 &
+wait
+
+# bsim prefixes every console line with the device and simulated time
+grep -o 'BSIM,.*' "$out/central.log" > "$out/results.csv"
+cat "$out/results.csv"
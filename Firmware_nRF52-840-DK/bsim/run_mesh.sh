@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+# Multi-node BabbleSim mesh bench: MESH_NODES copies of the firmware built
+# with overlay-mesh.conf (Sensor Server, unprovisioned) and the
+# provisioner / Sensor Client in bsim/mesh_client, all on one simulated
+# 2.4 GHz channel. The client provisions every node, sets its publication
+# to the group it listens on and checks the Sensor Status messages.
+# Runs headless; needs ZEPHYR_BASE and BSIM_OUT_PATH set up as for
+# Zephyr's own bsim tests, and west.
+#
+# Results: $BENCH_OUT/mesh.csv, one line per node. Fails unless the
+# client reports MESH,done,pass.
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+app=$(dirname "$here")
+out=${BENCH_OUT:-$here/out}
+sim_id=${SIM_ID:-somnosense_mesh}
+nodes=${MESH_NODES:-3}
+# Provisioning (a few seconds a node) plus the 60 s observe window
+sim_length_us=${SIM_LENGTH_US:-180000000}
+
+: "${ZEPHYR_BASE:?}" "${BSIM_OUT_PATH:?}"
+
+west build -p auto -b nrf52_bsim -d "$out/mesh_node" "$app/zephyr" -- \
+    -DOVERLAY_CONFIG="overlay-mesh.conf;$here/mesh_node.conf"
+west build -p auto -b nrf52_bsim -d "$out/mesh_client" "$here/mesh_client" -- \
+    -DCONFIG_MESH_CLIENT_NODES="$nodes"
+
+mkdir -p "$out"
+(cd "$BSIM_OUT_PATH/bin" &&
+    ./bs_2G4_phy_v1 -s="$sim_id" -D=$((nodes + 1)) -sim_length="$sim_length_us") &
+"$out/mesh_client/zephyr/zephyr.exe" -s="$sim_id" -d=0 -rs=1 > "$out/mesh_client.log" 2>&1 &
+# Distinct random seeds give every node its own identity address, and so
+# its own device UUID
+for d in $(seq "$nodes"); do
+    "$out/mesh_node/zephyr/zephyr.exe" -s="$sim_id" -d="$d" -rs=$((d + 1)) \
+        > "$out/mesh_node$d.log" 2>&1 &
+done
+wait
+
+# bsim prefixes every console line with the device and simulated time
+grep -o 'MESH,.*' "$out/mesh_client.log" > "$out/mesh.csv"
+cat "$out/mesh.csv"
+grep -q '^MESH,done,pass$' "$out/mesh.csv"
@@ -0,0 +1,108 @@
+/* dht_emul.c - Emulated DHT11 for host builds
+ *
+ * Answers the same channels as the DHT driver. Every fetch moves both
+ * readings one small bounded step, in the DHT11's 0.1 C / 1 % resolution,
+ * so consumers see changing data at any sampling rate, until
+ * dht_emul_set() pins them to externally supplied values.
+ */
+
+#define DT_DRV_COMPAT somnosense_dht_emul
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/sensor.h>
+#include <sys/util.h>
+
+#include "dht_emul.h"
+
+struct dht_emul_config {
+    int16_t temp_centi;
+    int16_t hum_centi;
+};
+
+struct dht_emul_data {
+    int16_t temp_centi;
+    int16_t hum_centi;
+    uint32_t lcg;
+    bool held;  /* set by dht_emul_set(), no more walking */
+};
+
+/* -1, 0 or +1 */
+static int dht_emul_step(struct dht_emul_data *data)
+{
+    data->lcg = data->lcg * 1664525u + 1013904223u;
+    return (int)((data->lcg >> 16) % 3) - 1;
+}
+
+static int dht_emul_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    struct dht_emul_data *data = dev->data;
+
+    if (data->held) {
+        return 0;
+    }
+
+    data->temp_centi = CLAMP(data->temp_centi + dht_emul_step(data) * 10, 0, 5000);
+    data->hum_centi = CLAMP(data->hum_centi + dht_emul_step(data) * 100, 2000, 9000);
+    return 0;
+}
+
+static int dht_emul_channel_get(const struct device *dev, enum sensor_channel chan,
+                                struct sensor_value *val)
+{
+    struct dht_emul_data *data = dev->data;
+    int16_t centi;
+
+    switch (chan) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+        centi = data->temp_centi;
+        break;
+    case SENSOR_CHAN_HUMIDITY:
+        centi = data->hum_centi;
+        break;
+    default:
+        return -ENOTSUP;
+    }
+
+    val->val1 = centi / 100;
+    val->val2 = (centi % 100) * 10000;
+    return 0;
+}
+
+void dht_emul_set(const struct device *dev, int16_t temp_centi, int16_t hum_centi)
+{
+    struct dht_emul_data *data = dev->data;
+
+    data->temp_centi = temp_centi;
+    data->hum_centi = hum_centi;
+    data->held = true;
+}
+
+static const struct sensor_driver_api dht_emul_api = {
+    .sample_fetch = dht_emul_sample_fetch,
+    .channel_get = dht_emul_channel_get,
+};
+
+static int dht_emul_init(const struct device *dev)
+{
+    const struct dht_emul_config *cfg = dev->config;
+    struct dht_emul_data *data = dev->data;
+
+    data->temp_centi = cfg->temp_centi;
+    data->hum_centi = cfg->hum_centi;
+    data->lcg = (uint32_t)(uintptr_t)dev;
+    return 0;
+}
+
+#define DHT_EMUL_DEFINE(n)                                              \
+    static struct dht_emul_data dht_emul_data_##n;                      \
+    static const struct dht_emul_config dht_emul_config_##n = {         \
+        .temp_centi = DT_INST_PROP(n, temperature_centi),               \
+        .hum_centi = DT_INST_PROP(n, humidity_centi),                   \
+    };                                                                  \
+    DEVICE_DT_INST_DEFINE(n, dht_emul_init, NULL,                       \
+                          &dht_emul_data_##n, &dht_emul_config_##n,     \
+                          POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,     \
+                          &dht_emul_api);
+
+DT_INST_FOREACH_STATUS_OKAY(DHT_EMUL_DEFINE)
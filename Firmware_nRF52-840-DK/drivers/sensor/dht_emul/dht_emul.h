@@ -0,0 +1,15 @@
+#ifndef DHT_EMUL_H
+#define DHT_EMUL_H
+
+#include <device.h>
+
+/**
+ * @brief Sets the readings the emulated DHT11 answers from now on and
+ *        stops its random walk, so a recorded signal comes out unchanged.
+ * @param dev Emulated sensor (DEVICE_DT_GET of a somnosense,dht-emul node)
+ * @param temp_centi Temperature in 0.01 C
+ * @param hum_centi Relative humidity in 0.01 %
+ */
+void dht_emul_set(const struct device *dev, int16_t temp_centi, int16_t hum_centi);
+
+#endif
@@ -0,0 +1,197 @@
+/* seeed_mgs.c - Driver for the Seeed multichannel gas sensor */
+
+#define DT_DRV_COMPAT seeed_multichannel_gas
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/i2c.h>
+#include <drivers/sensor.h>
+#include <logging/log.h>
+#include <pm/device.h>
+#include <sys/byteorder.h>
+
+#include "seeed_mgs.h"
+
+LOG_MODULE_REGISTER(seeed_mgs, CONFIG_SENSOR_LOG_LEVEL);
+
+#ifdef CONFIG_SEEED_MGS_BURST_READ
+
+static int seeed_mgs_transfer(const struct device *dev)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+    struct seeed_mgs_data *data = dev->data;
+    uint8_t reg = SEEED_MGS_REG_CO;
+
+    /* Register pointer auto-increments, one write-read covers the block */
+    return i2c_write_read_dt(&cfg->bus, &reg, 1, data->raw, sizeof(data->raw));
+}
+
+#else
+
+static const uint8_t seeed_mgs_regs[SEEED_MGS_CHANNEL_COUNT] = {
+    SEEED_MGS_REG_CO, SEEED_MGS_REG_NO2, SEEED_MGS_REG_NH3,
+    SEEED_MGS_REG_CH4, SEEED_MGS_REG_C2H5OH,
+};
+
+/* Write/read pair per register, built once at init and handed to a single
+ * i2c_transfer() so the bus driver runs all of them back to back.
+ */
+static void seeed_mgs_msgs_build(struct seeed_mgs_data *data)
+{
+    for (int i = 0; i < SEEED_MGS_CHANNEL_COUNT; i++) {
+        struct i2c_msg *wr = &data->msgs[i * 2];
+        struct i2c_msg *rd = &data->msgs[i * 2 + 1];
+
+        wr->buf = (uint8_t *)&seeed_mgs_regs[i];
+        wr->len = 1;
+        wr->flags = I2C_MSG_WRITE | (i ? I2C_MSG_RESTART : 0);
+
+        rd->buf = &data->raw[i * sizeof(uint16_t)];
+        rd->len = sizeof(uint16_t);
+        rd->flags = I2C_MSG_RESTART | I2C_MSG_READ;
+    }
+    data->msgs[ARRAY_SIZE(data->msgs) - 1].flags |= I2C_MSG_STOP;
+}
+
+static int seeed_mgs_transfer(const struct device *dev)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+    struct seeed_mgs_data *data = dev->data;
+
+    return i2c_transfer_dt(&cfg->bus, data->msgs, ARRAY_SIZE(data->msgs));
+}
+
+#endif /* CONFIG_SEEED_MGS_BURST_READ */
+
+static int seeed_mgs_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    struct seeed_mgs_data *data = dev->data;
+    int ret;
+
+    if (chan != SENSOR_CHAN_ALL) {
+        return -ENOTSUP;
+    }
+
+    data->valid = 0;
+    ret = seeed_mgs_transfer(dev);
+    if (ret) {
+        LOG_WRN("I2C block read failed (err %d)", ret);
+        return ret;
+    }
+
+    for (int i = 0; i < SEEED_MGS_CHANNEL_COUNT; i++) {
+        if (sys_get_be16(&data->raw[i * sizeof(uint16_t)]) != SEEED_MGS_RAW_INVALID) {
+            data->valid |= BIT(i);
+        }
+    }
+    return 0;
+}
+
+static int seeed_mgs_channel_get(const struct device *dev, enum sensor_channel chan,
+                                 struct sensor_value *val)
+{
+    struct seeed_mgs_data *data = dev->data;
+    int idx = (int)chan - SENSOR_CHAN_SEEED_MGS_CO;
+
+    if (idx < 0 || idx >= SEEED_MGS_CHANNEL_COUNT) {
+        return -ENOTSUP;
+    }
+    if (!(data->valid & BIT(idx))) {
+        return -ENODATA;
+    }
+
+    uint16_t raw = sys_get_be16(&data->raw[idx * sizeof(uint16_t)]);
+
+    val->val1 = raw / SEEED_MGS_SCALE;
+    val->val2 = (raw % SEEED_MGS_SCALE) * (1000000 / SEEED_MGS_SCALE);
+    return 0;
+}
+
+static const struct sensor_driver_api seeed_mgs_api = {
+    .sample_fetch = seeed_mgs_sample_fetch,
+    .channel_get = seeed_mgs_channel_get,
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+    .trigger_set = seeed_mgs_trigger_set,
+#endif
+};
+
+#ifdef CONFIG_PM_DEVICE
+/* Only the supply can be switched; the sensor has no sleep command */
+static int seeed_mgs_pm_action(const struct device *dev, enum pm_device_action action)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+
+    if (!cfg->power_gpio.port) {
+        return -ENOTSUP;
+    }
+
+    switch (action) {
+    case PM_DEVICE_ACTION_RESUME:
+        return gpio_pin_set_dt(&cfg->power_gpio, 1);
+    case PM_DEVICE_ACTION_SUSPEND:
+        return gpio_pin_set_dt(&cfg->power_gpio, 0);
+    default:
+        return -ENOTSUP;
+    }
+}
+
+#define SEEED_MGS_PM_ACTION seeed_mgs_pm_action
+#define SEEED_MGS_PM_CFG(n) \
+    .power_gpio = GPIO_DT_SPEC_INST_GET_OR(n, power_gpios, {0}),
+#else
+#define SEEED_MGS_PM_ACTION NULL
+#define SEEED_MGS_PM_CFG(n)
+#endif /* CONFIG_PM_DEVICE */
+
+static int seeed_mgs_init(const struct device *dev)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+
+    if (!device_is_ready(cfg->bus.bus)) {
+        LOG_ERR("I2C bus %s not ready", cfg->bus.bus->name);
+        return -ENODEV;
+    }
+
+#ifdef CONFIG_PM_DEVICE
+    if (cfg->power_gpio.port) {
+        int ret = gpio_pin_configure_dt(&cfg->power_gpio, GPIO_OUTPUT_ACTIVE);
+
+        if (ret) {
+            LOG_ERR("Power line setup failed (err %d)", ret);
+            return ret;
+        }
+    }
+#endif
+
+#ifndef CONFIG_SEEED_MGS_BURST_READ
+    seeed_mgs_msgs_build(dev->data);
+#endif
+
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+    return seeed_mgs_init_interrupt(dev);
+#else
+    return 0;
+#endif
+}
+
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+#define SEEED_MGS_TRIGGER_CFG(n)                                        \
+    .int_gpio = GPIO_DT_SPEC_INST_GET_OR(n, int_gpios, {0}),            \
+    .poll_period_ms = DT_INST_PROP(n, poll_period_ms),
+#else
+#define SEEED_MGS_TRIGGER_CFG(n)
+#endif
+
+#define SEEED_MGS_DEFINE(n)                                             \
+    static struct seeed_mgs_data seeed_mgs_data_##n;                    \
+    static const struct seeed_mgs_config seeed_mgs_config_##n = {       \
+        .bus = I2C_DT_SPEC_INST_GET(n),                                 \
+        SEEED_MGS_TRIGGER_CFG(n)                                        \
+        SEEED_MGS_PM_CFG(n)                                             \
+    };                                                                  \
+    DEVICE_DT_INST_DEFINE(n, seeed_mgs_init, SEEED_MGS_PM_ACTION,       \
+                          &seeed_mgs_data_##n, &seeed_mgs_config_##n,   \
+                          POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,     \
+                          &seeed_mgs_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SEEED_MGS_DEFINE)
@@ -0,0 +1,58 @@
+/* seeed_mgs.h - Private definitions of the Seeed multichannel gas driver */
+#ifndef SEEED_MGS_PRIV_H
+#define SEEED_MGS_PRIV_H
+
+#include <device.h>
+#include <drivers/gpio.h>
+#include <drivers/i2c.h>
+#include <drivers/sensor.h>
+
+#include <seeed_mgs.h>
+
+/* Register map from Seeed/Arduino source */
+#define SEEED_MGS_REG_CO        0x02
+#define SEEED_MGS_REG_NO2       0x04
+#define SEEED_MGS_REG_NH3       0x06
+#define SEEED_MGS_REG_CH4       0x08
+#define SEEED_MGS_REG_C2H5OH    0x0A
+
+/* The five 16-bit big-endian registers are contiguous: 0x02..0x0B */
+#define SEEED_MGS_BLOCK_LEN     (SEEED_MGS_CHANNEL_COUNT * sizeof(uint16_t))
+#define SEEED_MGS_RAW_INVALID   0xFFFF  /* value returned while a channel is not ready */
+#define SEEED_MGS_SCALE         100     /* raw / scale => ppm */
+
+struct seeed_mgs_config {
+    struct i2c_dt_spec bus;
+#ifdef CONFIG_PM_DEVICE
+    struct gpio_dt_spec power_gpio;
+#endif
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+    struct gpio_dt_spec int_gpio;
+    uint32_t poll_period_ms;
+#endif
+};
+
+struct seeed_mgs_data {
+    uint8_t raw[SEEED_MGS_BLOCK_LEN];
+    uint8_t valid;  /* BIT(n) set when channel n held a reading in the last fetch */
+#ifndef CONFIG_SEEED_MGS_BURST_READ
+    struct i2c_msg msgs[SEEED_MGS_CHANNEL_COUNT * 2];
+#endif
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+    const struct device *dev;
+    struct gpio_callback gpio_cb;
+    struct k_work_delayable work;
+    sensor_trigger_handler_t handler;
+    struct sensor_trigger trigger;
+#endif
+};
+
+#ifdef CONFIG_SEEED_MGS_TRIGGER
+int seeed_mgs_trigger_set(const struct device *dev,
+                          const struct sensor_trigger *trig,
+                          sensor_trigger_handler_t handler);
+
+int seeed_mgs_init_interrupt(const struct device *dev);
+#endif
+
+#endif /* SEEED_MGS_PRIV_H */
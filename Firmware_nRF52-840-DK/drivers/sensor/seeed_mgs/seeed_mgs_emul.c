@@ -0,0 +1,105 @@
+/* seeed_mgs_emul.c - I2C emulator for the Seeed multichannel gas sensor,
+ * used on native_posix so the driver runs without hardware.
+ */
+
+#define DT_DRV_COMPAT seeed_multichannel_gas
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/emul.h>
+#include <drivers/i2c.h>
+#include <drivers/i2c_emul.h>
+#include <logging/log.h>
+#include <sys/byteorder.h>
+
+#include "seeed_mgs.h"
+#include "seeed_mgs_emul.h"
+
+LOG_MODULE_REGISTER(seeed_mgs_emul, CONFIG_SENSOR_LOG_LEVEL);
+
+#define SEEED_MGS_EMUL_REG_COUNT 0x10
+
+struct seeed_mgs_emul_data {
+    struct i2c_emul emul_i2c;
+    uint8_t regs[SEEED_MGS_EMUL_REG_COUNT];
+    uint8_t cur_reg;
+    uint32_t transfers;
+};
+
+struct seeed_mgs_emul_cfg {
+    const char *i2c_label;
+    struct seeed_mgs_emul_data *data;
+    uint16_t addr;
+};
+
+static int seeed_mgs_emul_transfer(struct i2c_emul *emul, struct i2c_msg *msgs, int num_msgs, int addr)
+{
+    struct seeed_mgs_emul_data *data = CONTAINER_OF(emul, struct seeed_mgs_emul_data, emul_i2c);
+
+    data->transfers++;
+    for (int i = 0; i < num_msgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+
+        if ((msg->flags & I2C_MSG_RW_MASK) == I2C_MSG_WRITE) {
+            if (msg->len == 0) {
+                continue;
+            }
+            /* First byte selects the register, the sensor has no writable ones */
+            data->cur_reg = msg->buf[0];
+            continue;
+        }
+
+        for (uint32_t n = 0; n < msg->len; n++) {
+            if (data->cur_reg >= SEEED_MGS_EMUL_REG_COUNT) {
+                return -EIO;
+            }
+            msg->buf[n] = data->regs[data->cur_reg++];
+        }
+    }
+    return 0;
+}
+
+static const struct i2c_emul_api seeed_mgs_emul_api = {
+    .transfer = seeed_mgs_emul_transfer,
+};
+
+void seeed_mgs_emul_set_raw(const struct emul *target, int ch, uint16_t raw)
+{
+    const struct seeed_mgs_emul_cfg *cfg = target->cfg;
+
+    sys_put_be16(raw, &cfg->data->regs[SEEED_MGS_REG_CO + ch * sizeof(uint16_t)]);
+}
+
+uint32_t seeed_mgs_emul_transfer_count(const struct emul *target)
+{
+    const struct seeed_mgs_emul_cfg *cfg = target->cfg;
+
+    return cfg->data->transfers;
+}
+
+static int seeed_mgs_emul_init(const struct emul *target, const struct device *parent)
+{
+    const struct seeed_mgs_emul_cfg *cfg = target->cfg;
+    struct seeed_mgs_emul_data *data = cfg->data;
+
+    data->emul_i2c.api = &seeed_mgs_emul_api;
+    data->emul_i2c.addr = cfg->addr;
+
+    /* Plausible clean-air defaults (raw = ppm * 100) */
+    for (int ch = 0; ch < SEEED_MGS_CHANNEL_COUNT; ch++) {
+        seeed_mgs_emul_set_raw(target, ch, 100 * (ch + 1));
+    }
+
+    return i2c_emul_register(parent, target->dev_label, &data->emul_i2c);
+}
+
+#define SEEED_MGS_EMUL(n)                                                 \
+    static struct seeed_mgs_emul_data seeed_mgs_emul_data_##n;                  \
+    static const struct seeed_mgs_emul_cfg seeed_mgs_emul_cfg_##n = {           \
+        .i2c_label = DT_INST_BUS_LABEL(n),                          \
+        .data = &seeed_mgs_emul_data_##n,                                 \
+        .addr = DT_INST_REG_ADDR(n),                                \
+    };                                                              \
+    EMUL_DEFINE(seeed_mgs_emul_init, DT_DRV_INST(n), &seeed_mgs_emul_cfg_##n)
+
+DT_INST_FOREACH_STATUS_OKAY(SEEED_MGS_EMUL)
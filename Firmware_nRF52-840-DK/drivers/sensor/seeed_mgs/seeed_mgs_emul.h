@@ -0,0 +1,19 @@
+#ifndef SEEED_MGS_EMUL_H
+#define SEEED_MGS_EMUL_H
+
+#include <drivers/emul.h>
+
+/**
+ * @brief Sets the raw 16-bit register value the emulator returns for a channel.
+ * @param target Emulator instance (see emul_get_binding)
+ * @param ch Channel index, 0 (CO) .. SEEED_MGS_CHANNEL_COUNT - 1
+ * @param raw Raw value, 0xFFFF marks the channel as not ready
+ */
+void seeed_mgs_emul_set_raw(const struct emul *target, int ch, uint16_t raw);
+
+/**
+ * @brief Returns the number of I2C transactions the emulator has served.
+ */
+uint32_t seeed_mgs_emul_transfer_count(const struct emul *target);
+
+#endif
@@ -0,0 +1,104 @@
+/* seeed_mgs_trigger.c - Data-ready trigger for the Seeed multichannel gas sensor.
+ * Uses the optional int-gpios line when wired, otherwise a delayable work
+ * item on the system work queue fetches every poll-period-ms. Either way the
+ * sample is fetched before the handler runs.
+ */
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/gpio.h>
+#include <drivers/sensor.h>
+#include <logging/log.h>
+
+#include "seeed_mgs.h"
+
+LOG_MODULE_DECLARE(seeed_mgs, CONFIG_SENSOR_LOG_LEVEL);
+
+static bool seeed_mgs_has_int(const struct seeed_mgs_config *cfg)
+{
+    return cfg->int_gpio.port != NULL;
+}
+
+static void seeed_mgs_work_cb(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct seeed_mgs_data *data = CONTAINER_OF(dwork, struct seeed_mgs_data, work);
+    const struct seeed_mgs_config *cfg = data->dev->config;
+    sensor_trigger_handler_t handler = data->handler;
+
+    if (handler == NULL) {
+        return;
+    }
+
+    /* No data-ready line: the trigger paces itself at poll-period-ms */
+    if (!seeed_mgs_has_int(cfg)) {
+        k_work_schedule(dwork, K_MSEC(cfg->poll_period_ms));
+    }
+
+    /* Fetch here so handlers only need sensor_channel_get() */
+    if (sensor_sample_fetch(data->dev) == 0) {
+        handler(data->dev, &data->trigger);
+    }
+}
+
+static void seeed_mgs_gpio_cb(const struct device *port, struct gpio_callback *cb, uint32_t pins)
+{
+    struct seeed_mgs_data *data = CONTAINER_OF(cb, struct seeed_mgs_data, gpio_cb);
+
+    k_work_reschedule(&data->work, K_NO_WAIT);
+}
+
+int seeed_mgs_trigger_set(const struct device *dev,
+                          const struct sensor_trigger *trig,
+                          sensor_trigger_handler_t handler)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+    struct seeed_mgs_data *data = dev->data;
+
+    if (trig->type != SENSOR_TRIG_DATA_READY) {
+        return -ENOTSUP;
+    }
+
+    data->handler = handler;
+    data->trigger = *trig;
+
+    if (seeed_mgs_has_int(cfg)) {
+        return gpio_pin_interrupt_configure_dt(&cfg->int_gpio,
+                                               handler ? GPIO_INT_EDGE_TO_ACTIVE
+                                                       : GPIO_INT_DISABLE);
+    }
+
+    if (handler) {
+        k_work_reschedule(&data->work, K_NO_WAIT);
+    } else {
+        k_work_cancel_delayable(&data->work);
+    }
+    return 0;
+}
+
+int seeed_mgs_init_interrupt(const struct device *dev)
+{
+    const struct seeed_mgs_config *cfg = dev->config;
+    struct seeed_mgs_data *data = dev->data;
+    int ret;
+
+    data->dev = dev;
+    k_work_init_delayable(&data->work, seeed_mgs_work_cb);
+
+    if (!seeed_mgs_has_int(cfg)) {
+        return 0;
+    }
+
+    if (!device_is_ready(cfg->int_gpio.port)) {
+        LOG_ERR("Data-ready GPIO not ready");
+        return -ENODEV;
+    }
+
+    ret = gpio_pin_configure_dt(&cfg->int_gpio, GPIO_INPUT);
+    if (ret < 0) {
+        return ret;
+    }
+
+    gpio_init_callback(&data->gpio_cb, seeed_mgs_gpio_cb, BIT(cfg->int_gpio.pin));
+    return gpio_add_callback(cfg->int_gpio.port, &data->gpio_cb);
+}
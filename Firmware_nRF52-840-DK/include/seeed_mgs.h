@@ -0,0 +1,29 @@
+/* seeed_mgs.h - Extended sensor channels for the Seeed multichannel gas sensor */
+#ifndef SEEED_MGS_H
+#define SEEED_MGS_H
+
+#include <drivers/sensor.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Gas concentrations in ppm, in the sensor's register order.
+ * sensor_channel_get() returns -ENODATA for a channel the sensor reported
+ * as not ready in the last fetch.
+ */
+enum sensor_channel_seeed_mgs {
+    SENSOR_CHAN_SEEED_MGS_CO = SENSOR_CHAN_PRIV_START,
+    SENSOR_CHAN_SEEED_MGS_NO2,
+    SENSOR_CHAN_SEEED_MGS_NH3,
+    SENSOR_CHAN_SEEED_MGS_CH4,
+    SENSOR_CHAN_SEEED_MGS_C2H5OH,
+};
+
+#define SEEED_MGS_CHANNEL_COUNT 5
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEEED_MGS_H */
@@ -0,0 +1,8 @@
+#ifndef NATIVE_DEVICE_H
+#define NATIVE_DEVICE_H
+
+struct device {
+    const char *name;
+};
+
+#endif
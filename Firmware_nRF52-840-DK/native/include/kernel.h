@@ -0,0 +1,61 @@
+#ifndef NATIVE_KERNEL_H
+#define NATIVE_KERNEL_H
+
+#include <zephyr/types.h>
+#include <sys/util.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+
+#define __ASSERT_NO_MSG(test) assert(test)
+#define BUILD_ASSERT(expr, msg) _Static_assert(expr, msg)
+
+struct k_work;
+
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+/* There are no work queues here: a submitted item runs at once, in the
+ * submitting thread
+ */
+struct k_work {
+    k_work_handler_t handler;
+};
+
+struct k_work_q;
+
+static inline void k_work_init(struct k_work *work, k_work_handler_t handler)
+{
+    work->handler = handler;
+}
+
+static inline int k_work_submit(struct k_work *work)
+{
+    work->handler(work);
+    return 1;
+}
+
+static inline int k_work_submit_to_queue(struct k_work_q *queue, struct k_work *work)
+{
+    return k_work_submit(work);
+}
+
+/* The host monotonic clock stands in for the uptime and the cycle counter */
+static inline uint64_t native_clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static inline uint32_t k_uptime_get_32(void)
+{
+    return (uint32_t)(native_clock_ns() / 1000000u);
+}
+
+static inline uint32_t k_cycle_get_32(void)
+{
+    return (uint32_t)native_clock_ns();
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef NATIVE_SYS_ATOMIC_H
+#define NATIVE_SYS_ATOMIC_H
+
+#include <zephyr/types.h>
+
+/* Sequentially consistent, like the Zephyr atomics on target */
+typedef long atomic_t;
+typedef long atomic_val_t;
+
+static inline atomic_val_t atomic_get(const atomic_t *target)
+{
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *target, atomic_val_t value)
+{
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+#endif
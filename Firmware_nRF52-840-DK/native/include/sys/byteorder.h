@@ -0,0 +1,28 @@
+#ifndef NATIVE_SYS_BYTEORDER_H
+#define NATIVE_SYS_BYTEORDER_H
+
+#include <zephyr/types.h>
+
+static inline void sys_put_le16(uint16_t val, uint8_t dst[2])
+{
+    dst[0] = (uint8_t)val;
+    dst[1] = (uint8_t)(val >> 8);
+}
+
+static inline void sys_put_le32(uint32_t val, uint8_t dst[4])
+{
+    sys_put_le16((uint16_t)val, dst);
+    sys_put_le16((uint16_t)(val >> 16), &dst[2]);
+}
+
+static inline uint16_t sys_get_le16(const uint8_t src[2])
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static inline uint32_t sys_get_le32(const uint8_t src[4])
+{
+    return sys_get_le16(src) | ((uint32_t)sys_get_le16(&src[2]) << 16);
+}
+
+#endif
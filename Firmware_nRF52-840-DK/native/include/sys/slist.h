@@ -0,0 +1,34 @@
+#ifndef NATIVE_SYS_SLIST_H
+#define NATIVE_SYS_SLIST_H
+
+#include <zephyr/types.h>
+#include <sys/util.h>
+
+typedef struct _snode {
+    struct _snode *next;
+} sys_snode_t;
+
+typedef struct {
+    sys_snode_t *head;
+    sys_snode_t *tail;
+} sys_slist_t;
+
+#define SYS_SLIST_STATIC_INIT(ptr_to_list) { NULL, NULL }
+
+static inline void sys_slist_append(sys_slist_t *list, sys_snode_t *node)
+{
+    node->next = NULL;
+    if (list->tail) {
+        list->tail->next = node;
+    } else {
+        list->head = node;
+    }
+    list->tail = node;
+}
+
+#define SYS_SLIST_FOR_EACH_CONTAINER(list, cn, n)                               \
+    for (sys_snode_t *_sn = (list)->head;                                       \
+         _sn && ((cn) = CONTAINER_OF(_sn, __typeof__(*(cn)), n), 1);            \
+         _sn = _sn->next)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef NATIVE_SYS_UTIL_H
+#define NATIVE_SYS_UTIL_H
+
+#include <stddef.h>
+
+#define BIT(n)          (1UL << (n))
+#define BIT_MASK(n)     (BIT(n) - 1UL)
+#define ARRAY_SIZE(a)   (sizeof(a) / sizeof((a)[0]))
+#define MIN(a, b)       (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)       (((a) > (b)) ? (a) : (b))
+#define CLAMP(v, lo, hi) (((v) <= (lo)) ? (lo) : MIN(v, hi))
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+#define CONTAINER_OF(ptr, type, field) ((type *)(((char *)(ptr)) - offsetof(type, field)))
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef NATIVE_ZEPHYR_H
+#define NATIVE_ZEPHYR_H
+
+#include <kernel.h>
+
+#endif
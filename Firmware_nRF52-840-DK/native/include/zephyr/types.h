@@ -0,0 +1,8 @@
+#ifndef NATIVE_ZEPHYR_TYPES_H
+#define NATIVE_ZEPHYR_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#endif
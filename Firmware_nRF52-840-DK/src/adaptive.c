@@ -0,0 +1,227 @@
+/* adaptive.c - Sampling periods that follow the signal
+ *
+ * A sample ring consumer keeps an exponentially weighted mean and
+ * variance per channel, fed through a deadband one sensor step wide so
+ * a reading flickering between two adjacent steps counts as still. The
+ * change rate is the slope of the mean. A channel whose rate or variance
+ * crosses its threshold asks for CONFIG_APP_ADAPTIVE_MIN_MS; a quiet one
+ * backs off by CONFIG_APP_ADAPTIVE_BACKOFF_PCT per reading up to
+ * CONFIG_APP_ADAPTIVE_MAX_MS. The gas and env tasks run at the fastest
+ * period their channels ask for, so one rising gas samples all five.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <logging/log.h>
+#include <math.h>
+#ifdef CONFIG_SHELL
+#include <shell/shell.h>
+#endif
+
+#include "adaptive.h"
+#include "sample_ring.h"
+#include "gas_sensor.h"
+
+LOG_MODULE_REGISTER(adaptive, LOG_LEVEL_INF);
+
+#define ALPHA (CONFIG_APP_ADAPTIVE_ALPHA_PCT / 100.0f)
+
+/* Thresholds per channel: a CO or ethanol rise from cooking or breath, a
+ * window opened on a cold night. The variances catch the readings
+ * swinging while the average holds. The quantum is the sensor's
+ * resolution: the MGS reports 0.01 ppm, the DHT11 driver whole degrees
+ * and percent. Only steps larger than it reach the mean, so neither
+ * threshold sees quantization.
+ */
+struct chan_desc {
+    const char *name;
+    uint8_t kind;        /* enum sample_kind */
+    float rate_per_min;  /* |slope of the mean| per minute */
+    float var_max;       /* units squared */
+    float quantum;       /* sensor resolution, units */
+};
+
+static const struct chan_desc descs[ADAPTIVE_CHANNEL_COUNT] = {
+    [ADAPTIVE_CO]   = { "co",     SAMPLE_GAS, 0.5f,  0.04f,   0.01f },
+    [ADAPTIVE_NO2]  = { "no2",    SAMPLE_GAS, 0.05f, 0.0004f, 0.01f },
+    [ADAPTIVE_NH3]  = { "nh3",    SAMPLE_GAS, 0.5f,  0.04f,   0.01f },
+    [ADAPTIVE_CH4]  = { "ch4",    SAMPLE_GAS, 50.0f, 400.0f,  0.01f },
+    [ADAPTIVE_ETOH] = { "c2h5oh", SAMPLE_GAS, 1.0f,  0.25f,   0.01f },
+    [ADAPTIVE_TEMP] = { "temp",   SAMPLE_ENV, 0.2f,  0.01f,   1.0f },
+    [ADAPTIVE_HUM]  = { "hum",    SAMPLE_ENV, 2.0f,  1.0f,    1.0f },
+};
+
+struct chan_state {
+    float mean;
+    float var;
+    float rate;
+    float level;         /* input after the deadband */
+    uint32_t prev_ms;
+    uint32_t want_ms;
+    bool primed;
+};
+
+static struct chan_state chans[ADAPTIVE_CHANNEL_COUNT];
+static struct sched_task *tasks[SAMPLE_KIND_COUNT];
+static struct sample_consumer consumer;
+
+/* Reading of a channel, false when the sensor marked it not ready */
+static bool chan_value(enum adaptive_channel ch, const struct sample *smp, float *x)
+{
+    switch (ch) {
+    case ADAPTIVE_CO:   *x = smp->gas.co;   break;
+    case ADAPTIVE_NO2:  *x = smp->gas.no2;  break;
+    case ADAPTIVE_NH3:  *x = smp->gas.nh3;  break;
+    case ADAPTIVE_CH4:  *x = smp->gas.ch4;  break;
+    case ADAPTIVE_ETOH: *x = smp->gas.etoh; break;
+    case ADAPTIVE_TEMP: *x = smp->env.temp_c;  return true;
+    case ADAPTIVE_HUM:  *x = smp->env.hum_pct; return true;
+    default:
+        return false;
+    }
+    /* Gas channels follow enum gas_channel */
+    return smp->gas.valid & BIT(ch - ADAPTIVE_CO);
+}
+
+static void chan_update(enum adaptive_channel ch, float x, uint32_t ts, uint32_t period_ms)
+{
+    const struct chan_desc *desc = &descs[ch];
+    struct chan_state *st = &chans[ch];
+
+    if (!st->primed) {
+        st->mean = x;
+        st->var = 0.0f;
+        st->level = x;
+        st->prev_ms = ts;
+        st->want_ms = period_ms;
+        st->primed = true;
+        return;
+    }
+
+    /* One quantum either way is flicker; the extra half absorbs float
+     * rounding of the readings
+     */
+    if (fabsf(x - st->level) > desc->quantum * 1.5f) {
+        st->level = x;
+    }
+
+    float d = st->level - st->mean;
+    float prev_mean = st->mean;
+    uint32_t dt = ts - st->prev_ms;
+
+    st->mean += ALPHA * d;
+    st->var = (1.0f - ALPHA) * (st->var + ALPHA * d * d);
+    st->rate = dt ? fabsf(st->mean - prev_mean) * 60000.0f / dt : 0.0f;
+    st->prev_ms = ts;
+
+    if (st->rate > desc->rate_per_min || st->var > desc->var_max) {
+        st->want_ms = CONFIG_APP_ADAPTIVE_MIN_MS;
+    } else {
+        st->want_ms = MIN((uint64_t)st->want_ms * CONFIG_APP_ADAPTIVE_BACKOFF_PCT / 100,
+                          CONFIG_APP_ADAPTIVE_MAX_MS);
+    }
+}
+
+static void retune(struct sched_task *task, uint8_t kind)
+{
+    uint32_t want = CONFIG_APP_ADAPTIVE_MAX_MS;
+    int fastest = -1;
+
+    for (int ch = 0; ch < ADAPTIVE_CHANNEL_COUNT; ch++) {
+        if (descs[ch].kind == kind && chans[ch].primed && chans[ch].want_ms <= want) {
+            want = chans[ch].want_ms;
+            fastest = ch;
+        }
+    }
+
+    if (fastest < 0) {
+        return;
+    }
+#if defined(CONFIG_APP_POWER) && !defined(CONFIG_APP_SYNTH_SENSORS)
+    /* The gas supply may be off for the old period; the gating powers
+     * it up for a faster one and holds the task until it has warmed
+     */
+    if (kind == SAMPLE_GAS) {
+        want = gas_sensor_set_period(want);
+    }
+#endif
+    if (want == task->period_ms) {
+        return;
+    }
+    if (want < task->period_ms) {
+        LOG_INF("%s speeds up for %s", task->name, descs[fastest].name);
+    }
+    sched_set_period(task, want);
+}
+
+static void consumer_handler(struct k_work *work)
+{
+    struct sample smp;
+
+    while (sample_ring_read(&consumer.reader, &smp) == 0) {
+        struct sched_task *task = smp.kind < SAMPLE_KIND_COUNT ? tasks[smp.kind] : NULL;
+
+        if (!task) {
+            continue;
+        }
+
+        for (int ch = 0; ch < ADAPTIVE_CHANNEL_COUNT; ch++) {
+            float x;
+
+            if (descs[ch].kind == smp.kind && chan_value(ch, &smp, &x)) {
+                chan_update(ch, x, smp.timestamp_ms, task->period_ms);
+            }
+        }
+        retune(task, smp.kind);
+    }
+}
+
+void adaptive_init(struct sched_task *gas, struct sched_task *env)
+{
+    tasks[SAMPLE_GAS] = gas;
+    tasks[SAMPLE_ENV] = env;
+    sample_ring_subscribe(&consumer, NULL, consumer_handler);
+}
+
+int adaptive_get(enum adaptive_channel ch, struct adaptive_info *info)
+{
+    if (ch >= ADAPTIVE_CHANNEL_COUNT) {
+        return -EINVAL;
+    }
+    if (!chans[ch].primed) {
+        return -ENODATA;
+    }
+
+    info->name = descs[ch].name;
+    info->mean = chans[ch].mean;
+    info->var = chans[ch].var;
+    info->rate = chans[ch].rate;
+    info->want_ms = chans[ch].want_ms;
+    info->period_ms = tasks[descs[ch].kind]->period_ms;
+    return 0;
+}
+
+#ifdef CONFIG_SHELL
+/* Fixed point, without float formatting in the shell */
+static int cmd_adaptive(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "%-8s %10s %12s %10s %8s %8s %8s", "channel", "mean", "var",
+                "rate/min", "want ms", "task ms", "per hour");
+    for (int ch = 0; ch < ADAPTIVE_CHANNEL_COUNT; ch++) {
+        struct adaptive_info info;
+
+        if (adaptive_get(ch, &info)) {
+            shell_print(sh, "%-8s no reading yet", descs[ch].name);
+            continue;
+        }
+        shell_print(sh, "%-8s %10d %12d %10d %8u %8u %8u", info.name,
+                    (int32_t)(info.mean * 100), (int32_t)(info.var * 10000),
+                    (int32_t)(info.rate * 100), info.want_ms, info.period_ms,
+                    3600000 / info.period_ms);
+    }
+    shell_print(sh, "mean and rate in 0.01, variance in 0.0001 channel units");
+    return 0;
+}
+
+SHELL_CMD_REGISTER(adaptive, NULL, "Adaptive sampling state and rate per channel", cmd_adaptive);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,42 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <zephyr/types.h>
+#include "sensor_sched.h"
+
+/* Channels tracked, the five gases then the DHT11 readings */
+enum adaptive_channel {
+    ADAPTIVE_CO,
+    ADAPTIVE_NO2,
+    ADAPTIVE_NH3,
+    ADAPTIVE_CH4,
+    ADAPTIVE_ETOH,
+    ADAPTIVE_TEMP,
+    ADAPTIVE_HUM,
+    ADAPTIVE_CHANNEL_COUNT
+};
+
+struct adaptive_info {
+    const char *name;
+    float mean;          /* EWMA, channel units (ppm, C, %) */
+    float var;           /* EWM variance, units squared */
+    float rate;          /* slope of the mean at the last reading, units per minute */
+    uint32_t want_ms;    /* period this channel asks for */
+    uint32_t period_ms;  /* period of its task: the fastest of its channels */
+};
+
+/**
+ * @brief Subscribes the sampler to the sample ring. From then on every
+ *        gas and env record retunes the period of its task with
+ *        sched_set_period(). Call before sched_start().
+ */
+void adaptive_init(struct sched_task *gas, struct sched_task *env);
+
+/**
+ * @brief Current state of one channel.
+ * @return 0 on success, -EINVAL for an unknown channel, -ENODATA before
+ *         its first reading.
+ */
+int adaptive_get(enum adaptive_channel ch, struct adaptive_info *info);
+
+#endif
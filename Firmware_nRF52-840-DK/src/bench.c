@@ -0,0 +1,711 @@
+/* bench.c - Cycle-count benchmarks for the per-sample hot paths.
+ * Enabled with CONFIG_APP_BENCH, which builds a ztest image instead of the
+ * application: each case asserts its limits and prints CSV lines that can
+ * be collected from the console and compared between builds
+ * (bench/run_bench.sh).
+ */
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/i2c.h>
+#include <drivers/sensor.h>
+#include <sys/printk.h>
+#include <sys/byteorder.h>
+#include <string.h>
+#include <storage/flash_map.h>
+#include <ztest.h>
+#include <irq_offload.h>
+#ifdef CONFIG_ARCH_POSIX
+#include <time.h>
+#else
+#include <timing/timing.h>
+#endif
+
+#include "bench.h"
+#include "gas_sensor.h"
+#include "synth_sensors.h"
+#include "sample_ring.h"
+#include "sound_level.h"
+#include "sample_store.h"
+#include "sample_codec.h"
+#include "snapshot.h"
+
+#define BENCH_ITERATIONS 100
+
+#define GAS_NODE DT_NODELABEL(gas_sensor)
+
+/* Simulated time stands still while code runs on the POSIX arch, so host
+ * builds read the thread's CPU clock instead and report nanoseconds in
+ * the cycle columns as well.
+ */
+#ifdef CONFIG_ARCH_POSIX
+typedef uint64_t bench_stamp_t;
+
+static bench_stamp_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t bench_cycles(bench_stamp_t *start, bench_stamp_t *end)
+{
+    return *end - *start;
+}
+
+static uint64_t bench_cycles_to_ns(uint64_t cycles)
+{
+    return cycles;
+}
+#else
+typedef timing_t bench_stamp_t;
+
+static bench_stamp_t bench_now(void)
+{
+    return timing_counter_get();
+}
+
+static uint64_t bench_cycles(bench_stamp_t *start, bench_stamp_t *end)
+{
+    return timing_cycles_get(start, end);
+}
+
+static uint64_t bench_cycles_to_ns(uint64_t cycles)
+{
+    return timing_cycles_to_ns(cycles);
+}
+#endif
+
+uint32_t bench_measure(const char *name, bench_fn_t fn, void *ctx, uint32_t iterations)
+{
+    uint64_t total = 0, min = UINT64_MAX, max = 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        bench_stamp_t start = bench_now();
+        fn(ctx);
+        bench_stamp_t end = bench_now();
+        uint64_t cycles = bench_cycles(&start, &end);
+
+        total += cycles;
+        min = MIN(min, cycles);
+        max = MAX(max, cycles);
+    }
+
+    uint64_t avg = total / iterations;
+    uint32_t avg_ns = (uint32_t)bench_cycles_to_ns(avg);
+
+    printk("BENCH,%s,%u,%u,%u,%u,%u\n", name, iterations,
+           (uint32_t)min, (uint32_t)avg, (uint32_t)max, avg_ns);
+    return avg_ns;
+}
+
+#ifndef CONFIG_APP_SYNTH_SENSORS
+/* Baseline: one write-read round trip per gas register */
+static void bench_gas_per_register(void *ctx)
+{
+    const struct device *i2c_dev = DEVICE_DT_GET(DT_BUS(GAS_NODE));
+    uint8_t buf[2];
+
+    for (uint8_t reg = 0x02; reg <= 0x0A; reg += 2) {
+        (void)i2c_write_read(i2c_dev, DT_REG_ADDR(GAS_NODE), &reg, 1, buf, sizeof(buf));
+    }
+}
+
+static void bench_gas_read_all(void *ctx)
+{
+    struct gas_data gas;
+
+    (void)gas_sensor_read_all(ctx, &gas);
+}
+#endif /* CONFIG_APP_SYNTH_SENSORS */
+
+/* Per-sample stages after the bus transfer, on one shared record so every
+ * stage sees the output of the previous one
+ */
+static struct {
+    struct sample smp;
+    struct snapshot_state snap;
+    struct snapshot_batch batch;
+    uint8_t record[SNAPSHOT_LEN];
+} stage;
+
+#ifdef CONFIG_APP_SYNTH_SENSORS
+static void bench_synth_gas(void *ctx)
+{
+    synth_read_gas(&stage.smp.gas);
+}
+#endif
+
+/* DHT driver values to the ring record's floats, as the env task does */
+static void bench_env_convert(void *ctx)
+{
+    static const struct sensor_value temp = { .val1 = 21, .val2 = 500000 };
+    static const struct sensor_value hum = { .val1 = 45, .val2 = 0 };
+
+    stage.smp.env.temp_c = (float)sensor_value_to_double(&temp);
+    stage.smp.env.hum_pct = (float)sensor_value_to_double(&hum);
+}
+
+static void bench_snapshot_update(void *ctx)
+{
+    (void)snapshot_update(&stage.snap, &stage.smp);
+}
+
+static void bench_snapshot_encode(void *ctx)
+{
+    (void)snapshot_encode(&stage.snap, stage.record);
+}
+
+/* One full batch frame: SNAPSHOT_BATCH_MAX appends and the header */
+static void bench_snapshot_batch(void *ctx)
+{
+    for (int i = 0; i < SNAPSHOT_BATCH_MAX; i++) {
+        snapshot_batch_add(&stage.batch, stage.record);
+    }
+    (void)snapshot_batch_take(&stage.batch);
+}
+
+static void bench_ring_publish(void *ctx)
+{
+    struct sample smp = { .kind = SAMPLE_GAS, .gas = stage.smp.gas };
+
+    sample_ring_publish(&smp);
+}
+
+static void bench_ring_read(void *ctx)
+{
+    struct sample_reader *reader = ctx;
+    struct sample smp;
+
+    (void)sample_ring_read(reader, &smp);
+}
+
+#ifdef CONFIG_SOUND_ADC
+/* One full amplitude window: every block of the window plus the finish */
+#define LEVEL_WINDOW_SAMPLES (CONFIG_SOUND_ADC_RATE_HZ * CONFIG_SOUND_ADC_WINDOW_MS / 1000)
+
+static int16_t level_block[CONFIG_SOUND_ADC_BLOCK_SAMPLES];
+
+static void bench_sound_level_window(void *ctx)
+{
+    struct sound_level_acc acc;
+    struct sound_level level;
+
+    sound_level_reset(&acc);
+    for (uint32_t n = 0; n < LEVEL_WINDOW_SAMPLES; n += ARRAY_SIZE(level_block)) {
+        sound_level_feed(&acc, level_block, ARRAY_SIZE(level_block));
+    }
+    sound_level_finish(&acc, 2047, &level);
+}
+#endif
+
+/* Stress: one producer against three readers. Each record carries its
+ * seq in every payload field so a torn copy shows up as a mismatch.
+ *  - a thread at the producer's priority, taking turns at its yields;
+ *  - a k_timer expiry, which on a target with a real timer interrupt
+ *    lands anywhere inside a publish;
+ *  - an irq_offload() from the ring's bench hook, between the slot write
+ *    and its commit of every STRESS_MID_EVERY-th publish. It reads one
+ *    record per call, so it stays lapped and its next record is the one
+ *    being overwritten: the reads the seq check has to reject. On
+ *    native_posix and a single-core QEMU this is the only reader that
+ *    is sure to overlap a publish, so the test asserts it did.
+ */
+#define STRESS_RECORDS      20000
+#define STRESS_STACK_SIZE   1024
+#define STRESS_MID_EVERY    16
+#define STRESS_TIMER_READS  8
+
+enum {
+    STRESS_THREAD,
+    STRESS_TIMER,
+    STRESS_MID_PUBLISH,
+    STRESS_READERS
+};
+
+static const char *const stress_names[STRESS_READERS] = { "thread", "timer", "mid_publish" };
+
+struct stress_consumer {
+    struct sample_reader reader;
+    uint32_t last;
+    uint32_t consumed;
+    uint32_t torn;
+    uint32_t out_of_order;
+    uint32_t overlapped;  /* reads aimed at the slot being written */
+};
+
+static struct stress_consumer stress_consumers[STRESS_READERS];
+static volatile bool stress_done;
+static uint32_t stress_publishing;
+
+K_THREAD_STACK_ARRAY_DEFINE(stress_stacks, 2, STRESS_STACK_SIZE);
+static struct k_thread stress_threads[2];
+
+static int stress_read(struct stress_consumer *c)
+{
+    struct sample smp;
+    int err = sample_ring_read(&c->reader, &smp);
+
+    if (err) {
+        return err;
+    }
+
+    float v = (float)smp.seq;
+
+    if (smp.gas.co != v || smp.gas.no2 != v || smp.gas.nh3 != v ||
+        smp.gas.ch4 != v || smp.gas.etoh != v) {
+        c->torn++;
+    }
+    if (smp.seq <= c->last) {
+        c->out_of_order++;
+    }
+    c->last = smp.seq;
+    c->consumed++;
+    return 0;
+}
+
+static void stress_mid_publish(const void *arg)
+{
+    struct stress_consumer *c = &stress_consumers[STRESS_MID_PUBLISH];
+
+    /* Lapped: the oldest record left shares the slot being written */
+    if ((int32_t)(stress_publishing - CONFIG_SAMPLE_RING_SIZE - c->reader.next) >= 0) {
+        c->overlapped++;
+    }
+    (void)stress_read(c);
+}
+
+static void stress_hook(uint32_t seq)
+{
+    if (seq % STRESS_MID_EVERY == 0) {
+        stress_publishing = seq;
+        irq_offload(stress_mid_publish, NULL);
+    }
+}
+
+static void stress_timer_fn(struct k_timer *timer)
+{
+    struct stress_consumer *c = &stress_consumers[STRESS_TIMER];
+
+    for (int i = 0; i < STRESS_TIMER_READS && stress_read(c) == 0; i++) {
+    }
+}
+
+static K_TIMER_DEFINE(stress_timer, stress_timer_fn, NULL);
+
+static void stress_producer(void *p1, void *p2, void *p3)
+{
+    for (uint32_t i = 1; i <= STRESS_RECORDS; i++) {
+        struct sample smp = { .kind = SAMPLE_GAS };
+        float v = (float)(sample_ring_published() + 1);
+
+        smp.gas.co = smp.gas.no2 = smp.gas.nh3 = smp.gas.ch4 = smp.gas.etoh = v;
+        sample_ring_publish(&smp);
+        if ((i & 0x3F) == 0) {
+            k_yield();
+        }
+    }
+    stress_done = true;
+}
+
+static void stress_consumer_fn(void *p1, void *p2, void *p3)
+{
+    struct stress_consumer *c = p1;
+
+    for (;;) {
+        if (stress_read(c) != 0) {
+            if (stress_done) {
+                return;
+            }
+            k_yield();
+        }
+    }
+}
+
+static void test_ring_stress(void)
+{
+    uint32_t start = k_uptime_get_32();
+
+    stress_done = false;
+    for (int i = 0; i < STRESS_READERS; i++) {
+        memset(&stress_consumers[i], 0, sizeof(stress_consumers[i]));
+        sample_reader_init(&stress_consumers[i].reader);
+    }
+    sample_ring_bench_set_hook(stress_hook);
+    k_timer_start(&stress_timer, K_MSEC(1), K_MSEC(1));
+
+    k_thread_create(&stress_threads[1], stress_stacks[1], STRESS_STACK_SIZE,
+                    stress_consumer_fn, &stress_consumers[STRESS_THREAD], NULL, NULL,
+                    K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+    k_thread_create(&stress_threads[0], stress_stacks[0], STRESS_STACK_SIZE,
+                    stress_producer, NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+    for (int i = 0; i < ARRAY_SIZE(stress_threads); i++) {
+        k_thread_join(&stress_threads[i], K_FOREVER);
+    }
+
+    k_timer_stop(&stress_timer);
+    sample_ring_bench_set_hook(NULL);
+    /* What the interrupt readers had not got to yet, so every record is
+     * either read or counted lost
+     */
+    while (stress_read(&stress_consumers[STRESS_TIMER]) == 0) {
+    }
+    while (stress_read(&stress_consumers[STRESS_MID_PUBLISH]) == 0) {
+    }
+
+    for (int i = 0; i < STRESS_READERS; i++) {
+        struct stress_consumer *c = &stress_consumers[i];
+
+        printk("STRESS,sample_ring,%s,%u,%u,%u,%u,%u,%u\n", stress_names[i], STRESS_RECORDS,
+               c->consumed, c->reader.lost, c->torn, c->out_of_order, c->overlapped);
+    }
+    printk("STRESS,sample_ring,elapsed_ms,%u\n", k_uptime_get_32() - start);
+
+    for (int i = 0; i < STRESS_READERS; i++) {
+        struct stress_consumer *c = &stress_consumers[i];
+
+        zassert_equal(c->torn, 0, "%s read %u torn records", stress_names[i], c->torn);
+        zassert_equal(c->out_of_order, 0, "%s read %u records out of order",
+                      stress_names[i], c->out_of_order);
+        zassert_equal(c->consumed + c->reader.lost, STRESS_RECORDS,
+                      "%s accounts for %u of %u records", stress_names[i],
+                      c->consumed + c->reader.lost, STRESS_RECORDS);
+    }
+    zassert_true(stress_consumers[STRESS_MID_PUBLISH].overlapped > 0,
+                 "no read overlapped a publish");
+}
+
+#ifdef CONFIG_SAMPLE_STORE
+/* Codec trace: one hour of gas and env records at the default 2 s grid,
+ * slow random walks around typical bedroom values with sensor-sized noise.
+ */
+#define TRACE_RECORDS   3600
+#define TRACE_WINDOW    64
+
+/* Float payload plus timestamp and kind, as the old characteristics sent it */
+#define RAW_GAS_LEN     (4 + 1 + 5 * 4)
+#define RAW_ENV_LEN     (4 + 1 + 2 * 4)
+/* Fixed-width version 1 flash records */
+#define FIXED_GAS_LEN   (3 + 1 + 5 * 2)
+#define FIXED_ENV_LEN   (3 + 2 * 2)
+
+struct trace_state {
+    uint32_t rng;
+    int32_t gas[GAS_CHANNEL_COUNT];  /* 0.01 ppm */
+    int32_t temp;                    /* 0.01 C */
+    int32_t hum;                     /* 0.01 % */
+};
+
+static int32_t trace_step(struct trace_state *t, int32_t v, int32_t span, int32_t lo)
+{
+    t->rng = t->rng * 1103515245u + 12345u;
+    v += (int32_t)((t->rng >> 16) % (2 * span + 1)) - span;
+    return MAX(v, lo);
+}
+
+static void trace_init(struct trace_state *t)
+{
+    static const int32_t gas0[GAS_CHANNEL_COUNT] = { 150, 12, 80, 2500, 40 };
+
+    t->rng = 1;
+    memcpy(t->gas, gas0, sizeof(t->gas));
+    t->temp = 2150;
+    t->hum = 4500;
+}
+
+static void trace_sample(struct trace_state *t, uint32_t i, struct sample *smp)
+{
+    memset(smp, 0, sizeof(*smp));
+    smp->seq = i + 1;
+    smp->timestamp_ms = (i / 2) * 2000 + (i & 1);
+
+    if (i & 1) {
+        t->temp = trace_step(t, t->temp, 3, -1000);
+        t->hum = trace_step(t, t->hum, 10, 0);
+        smp->kind = SAMPLE_ENV;
+        smp->env.temp_c = t->temp / 100.0f;
+        smp->env.hum_pct = t->hum / 100.0f;
+        return;
+    }
+
+    smp->kind = SAMPLE_GAS;
+    smp->gas.valid = GAS_VALID_ALL;
+    for (int ch = 0; ch < GAS_CHANNEL_COUNT; ch++) {
+        t->gas[ch] = trace_step(t, t->gas[ch], 4, 0);
+    }
+    smp->gas.co = t->gas[0] / 100.0f;
+    smp->gas.no2 = t->gas[1] / 100.0f;
+    smp->gas.nh3 = t->gas[2] / 100.0f;
+    smp->gas.ch4 = t->gas[3] / 100.0f;
+    smp->gas.etoh = t->gas[4] / 100.0f;
+}
+
+struct codec_bench {
+    struct sample trace[TRACE_WINDOW];
+    struct sample_codec codec;
+    uint8_t buf[SAMPLE_CODEC_RECORD_MAX];
+    uint32_t next;
+};
+
+static struct codec_bench codec_bench;
+
+static void bench_codec_encode(void *ctx)
+{
+    struct codec_bench *b = ctx;
+
+    (void)sample_codec_encode(&b->codec, &b->trace[b->next++ % TRACE_WINDOW],
+                              b->buf, sizeof(b->buf));
+}
+
+static bool same_quantized(const struct sample *a, const struct sample *b)
+{
+    if (a->kind != b->kind || a->timestamp_ms != b->timestamp_ms) {
+        return false;
+    }
+    if (a->kind == SAMPLE_ENV) {
+        return snapshot_centi_i16(a->env.temp_c) == snapshot_centi_i16(b->env.temp_c) &&
+               snapshot_centi_u16(a->env.hum_pct) == snapshot_centi_u16(b->env.hum_pct);
+    }
+    return a->gas.valid == b->gas.valid &&
+           snapshot_centi_u16(a->gas.co) == snapshot_centi_u16(b->gas.co) &&
+           snapshot_centi_u16(a->gas.no2) == snapshot_centi_u16(b->gas.no2) &&
+           snapshot_centi_u16(a->gas.nh3) == snapshot_centi_u16(b->gas.nh3) &&
+           snapshot_centi_u16(a->gas.ch4) == snapshot_centi_u16(b->gas.ch4) &&
+           snapshot_centi_u16(a->gas.etoh) == snapshot_centi_u16(b->gas.etoh);
+}
+
+/* Packs the trace into store-sized blocks, decodes every block back and
+ * reports the bytes each encoding needs:
+ * CODEC,<records>,<raw float bytes>,<v1 fixed bytes>,<v2 bytes>,<raw/v2 x100>,<mismatches>
+ */
+static void test_codec_ratio(void)
+{
+    static uint8_t blk[SAMPLE_STORE_BLOCK_MAX];
+    static struct sample pending[SAMPLE_STORE_BLOCK_MAX / 2];
+    struct trace_state t;
+    struct sample_codec enc, dec;
+    uint32_t raw = 0, fixed = 0, packed = 0, mismatches = 0;
+    size_t len = 0, count = 0;
+
+    trace_init(&t);
+    for (uint32_t i = 0; i <= TRACE_RECORDS; i++) {
+        struct sample smp;
+
+        if (i < TRACE_RECORDS) {
+            trace_sample(&t, i, &smp);
+            raw += smp.kind == SAMPLE_GAS ? RAW_GAS_LEN : RAW_ENV_LEN;
+            fixed += smp.kind == SAMPLE_GAS ? FIXED_GAS_LEN : FIXED_ENV_LEN;
+        }
+
+        if (count && (i == TRACE_RECORDS || len + SAMPLE_CODEC_RECORD_MAX > sizeof(blk))) {
+            /* Close the block and check it decodes to what went in */
+            size_t off = SAMPLE_STORE_BLOCK_HDR_LEN;
+
+            sample_codec_reset(&dec, pending[0].timestamp_ms);
+            for (size_t r = 0; r < count; r++) {
+                struct sample out = { 0 };
+                int n = sample_codec_decode(&dec, &blk[off], len - off, &out);
+
+                if (n <= 0 || !same_quantized(&pending[r], &out)) {
+                    mismatches++;
+                    break;
+                }
+                off += n;
+            }
+            packed += len;
+            fixed += SAMPLE_STORE_BLOCK_HDR_LEN;
+            count = 0;
+        }
+        if (i == TRACE_RECORDS) {
+            break;
+        }
+
+        if (count == 0) {
+            sample_codec_reset(&enc, smp.timestamp_ms);
+            len = SAMPLE_STORE_BLOCK_HDR_LEN;
+        }
+        len += sample_codec_encode(&enc, &smp, &blk[len], sizeof(blk) - len);
+        pending[count++] = smp;
+    }
+
+    printk("CODEC,%u,%u,%u,%u,%u,%u\n", TRACE_RECORDS, raw, fixed, packed,
+           raw * 100 / packed, mismatches);
+    zassert_equal(mismatches, 0, "%u blocks did not decode to the trace", mismatches);
+    zassert_true(packed < fixed, "v2 blocks (%u bytes) not smaller than v1 (%u bytes)",
+                 packed, fixed);
+}
+#else
+static void test_codec_ratio(void)
+{
+    ztest_test_skip();
+}
+#endif /* CONFIG_SAMPLE_STORE */
+
+#if defined(CONFIG_SAMPLE_STORE) && FLASH_AREA_LABEL_EXISTS(sample_log_bench)
+/* Store and replay on the scratch partition: enough records to wrap the
+ * log, then a full replay that must come back gap-free from the oldest
+ * surviving record. The real sample-log partition is never touched.
+ */
+#define STORE_STRESS_RECORDS 60000
+
+static uint8_t store_block[SAMPLE_STORE_BLOCK_MAX];
+
+static void test_store_stress(void)
+{
+    struct sample_store_cursor cur;
+    uint32_t first, next, expect, blocks = 0, gaps = 0;
+    uint32_t start = k_uptime_get_32();
+    int len;
+
+    zassert_ok(sample_store_bench_open(FLASH_AREA_ID(sample_log_bench)),
+               "scratch log not mounted");
+
+    for (uint32_t i = 0; i < STORE_STRESS_RECORDS; i++) {
+        struct sample smp = { .seq = i + 1, .timestamp_ms = i * 100 };
+
+        if (i & 1) {
+            smp.kind = SAMPLE_ENV;
+            smp.env.temp_c = 21.5f;
+            smp.env.hum_pct = 40.25f;
+        } else {
+            smp.kind = SAMPLE_GAS;
+            smp.gas.co = (float)i / 100.0f;
+            smp.gas.valid = GAS_VALID_ALL;
+        }
+        sample_store_append(&smp);
+    }
+    sample_store_flush();
+    printk("STRESS,sample_store,append_ms,%u\n", k_uptime_get_32() - start);
+
+    start = k_uptime_get_32();
+    sample_store_range(&first, &next);
+    sample_store_cursor_init(&cur, first);
+    expect = first;
+    while ((len = sample_store_next(&cur, store_block, sizeof(store_block))) > 0) {
+        uint32_t seq = sys_get_le32(&store_block[4]);
+
+        if (seq != expect) {
+            gaps++;
+        }
+        expect = seq + store_block[1];
+        blocks++;
+    }
+
+    printk("STRESS,sample_store,replay,%u,%u,%u,%u,%d\n", next - first, blocks,
+           expect - first, gaps, len);
+    printk("STRESS,sample_store,replay_ms,%u\n", k_uptime_get_32() - start);
+    sample_store_bench_close();
+
+    zassert_equal(len, 0, "replay stopped with error %d", len);
+    zassert_true(blocks > 0, "nothing replayed");
+    zassert_equal(gaps, 0, "%u gaps in the replay", gaps);
+    zassert_equal(expect, next, "replay ended at %u, log at %u", expect, next);
+}
+#else
+static void test_store_stress(void)
+{
+    ztest_test_skip();
+}
+#endif
+
+/* Acquire, convert, publish, consume and encode one gas record, summed
+ * against the per-sample budget
+ */
+static void test_per_sample_budget(void)
+{
+    uint32_t budget_ns = CONFIG_APP_BENCH_BUDGET_US * 1000;
+    uint32_t per_sample_ns = 0;
+
+#ifdef CONFIG_APP_SYNTH_SENSORS
+    per_sample_ns += bench_measure("synth_gas", bench_synth_gas, NULL, BENCH_ITERATIONS);
+#else
+    const struct device *gas_dev;
+
+    zassert_ok(gas_sensor_init(&gas_dev), "gas sensor not ready");
+    bench_measure("gas_per_register", bench_gas_per_register, NULL, BENCH_ITERATIONS);
+    per_sample_ns += bench_measure("gas_read_all", bench_gas_read_all, (void *)gas_dev,
+                                   BENCH_ITERATIONS);
+#endif
+    stage.smp.kind = SAMPLE_GAS;
+    stage.smp.gas = (struct gas_data){ 1.5f, 0.08f, 0.9f, 2.0f, 4.0f, GAS_VALID_ALL };
+
+    struct sample_reader reader;
+
+    sample_reader_init(&reader);
+    per_sample_ns += bench_measure("ring_publish", bench_ring_publish, NULL, BENCH_ITERATIONS);
+    per_sample_ns += bench_measure("ring_read", bench_ring_read, &reader, BENCH_ITERATIONS);
+    per_sample_ns += bench_measure("snapshot_update", bench_snapshot_update, NULL,
+                                   BENCH_ITERATIONS);
+    per_sample_ns += bench_measure("snapshot_encode", bench_snapshot_encode, NULL,
+                                   BENCH_ITERATIONS);
+    bench_measure("snapshot_batch", bench_snapshot_batch, NULL, BENCH_ITERATIONS);
+
+    /* The env path converts instead of decoding a bus transfer */
+    stage.smp.kind = SAMPLE_ENV;
+    bench_measure("env_convert", bench_env_convert, NULL, BENCH_ITERATIONS);
+    bench_measure("snapshot_update_env", bench_snapshot_update, NULL, BENCH_ITERATIONS);
+
+#ifdef CONFIG_SAMPLE_STORE
+    struct trace_state trace;
+
+    trace_init(&trace);
+    for (uint32_t i = 0; i < TRACE_WINDOW; i++) {
+        trace_sample(&trace, i, &codec_bench.trace[i]);
+    }
+    sample_codec_reset(&codec_bench.codec, 0);
+    per_sample_ns += bench_measure("codec_encode", bench_codec_encode, &codec_bench,
+                                   BENCH_ITERATIONS);
+#endif
+
+    printk("BUDGET,per_sample,%u,%u,%s\n", per_sample_ns, budget_ns,
+           per_sample_ns <= budget_ns ? "ok" : "over");
+    zassert_true(per_sample_ns <= budget_ns, "one gas record takes %u ns, budget %u ns",
+                 per_sample_ns, budget_ns);
+}
+
+static void test_sound_level_window(void)
+{
+#ifdef CONFIG_SOUND_ADC
+    struct sound_level_acc acc;
+    struct sound_level level;
+
+    for (int i = 0; i < ARRAY_SIZE(level_block); i++) {
+        level_block[i] = 2048 + ((i * 37) % 512) - 256;
+    }
+    bench_measure("sound_level_window", bench_sound_level_window, NULL, 10);
+
+    /* A constant block at the bias is silence */
+    for (int i = 0; i < ARRAY_SIZE(level_block); i++) {
+        level_block[i] = 2048;
+    }
+    sound_level_reset(&acc);
+    sound_level_feed(&acc, level_block, ARRAY_SIZE(level_block));
+    sound_level_finish(&acc, 2047, &level);
+    zassert_equal(level.rms, 0, "silence reads rms %u", level.rms);
+#else
+    ztest_test_skip();
+#endif
+}
+
+void test_main(void)
+{
+#ifndef CONFIG_ARCH_POSIX
+    timing_init();
+    timing_start();
+#endif
+    printk("BENCH,board,%s\n", CONFIG_BOARD);
+
+    ztest_test_suite(bench,
+                     ztest_unit_test(test_per_sample_budget),
+                     ztest_unit_test(test_sound_level_window),
+                     ztest_unit_test(test_ring_stress),
+                     ztest_unit_test(test_codec_ratio),
+                     ztest_unit_test(test_store_stress));
+    ztest_run_test_suite(bench);
+    printk("BENCH,done\n");
+
+#ifndef CONFIG_ARCH_POSIX
+    timing_stop();
+#endif
+}
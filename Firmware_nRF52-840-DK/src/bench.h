@@ -0,0 +1,20 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <zephyr/types.h>
+
+/**
+ * @brief Function under measurement, called once per iteration.
+ */
+typedef void (*bench_fn_t)(void *ctx);
+
+/**
+ * @brief Runs fn for the given number of iterations and prints one
+ *        machine-readable result line:
+ *        BENCH,<name>,<iterations>,<min cycles>,<avg cycles>,<max cycles>,<avg ns>
+ *        On the POSIX arch the cycle columns are host nanoseconds.
+ * @return average time per iteration in ns.
+ */
+uint32_t bench_measure(const char *name, bench_fn_t fn, void *ctx, uint32_t iterations);
+
+#endif
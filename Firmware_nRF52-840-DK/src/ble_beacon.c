@@ -0,0 +1,166 @@
+/* ble_beacon.c - Snapshot broadcast in extended and periodic advertising */
+
+#include <zephyr.h>
+#include <bluetooth/bluetooth.h>
+#include <sys/printk.h>
+#include <sys/byteorder.h>
+#include <string.h>
+#include "ble_beacon.h"
+#include "snapshot.h"
+
+#define BEACON_MFR_LEN (2 + SNAPSHOT_LEN)
+
+/* Advertising intervals are in 0.625 ms units, periodic ones in 1.25 ms */
+#define BEACON_ADV_INTERVAL (CONFIG_BLE_BEACON_INTERVAL_MS * 8 / 5)
+#define BEACON_PER_INTERVAL (CONFIG_BLE_BEACON_INTERVAL_MS * 4 / 5)
+
+/* Every call below is a blocking HCI command. They run on a work queue of
+ * their own, so neither the Bluetooth RX thread nor the sensor scheduler
+ * on the system work queue waits for the controller.
+ */
+#define BEACON_STACK_SIZE 1024
+#define BEACON_PRIORITY   K_PRIO_PREEMPT(10)
+
+static K_THREAD_STACK_DEFINE(beacon_stack, BEACON_STACK_SIZE);
+static struct k_work_q beacon_q;
+
+/* Beacon queue only */
+static struct bt_le_ext_adv *adv;
+static bool enabled;
+
+/* The stack copies it on every set_data */
+static uint8_t mfr_data[BEACON_MFR_LEN];
+
+/* Newest snapshot and the time it last went out, shared with the
+ * consumer under the lock
+ */
+static struct k_spinlock lock;
+static uint8_t latest[SNAPSHOT_LEN];
+static int64_t last_update_ms;
+
+static atomic_t enable_request;
+
+static void update_handler(struct k_work *work);
+static void switch_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(update_work, update_handler);
+static K_WORK_DEFINE(switch_work, switch_handler);
+
+static const struct bt_data beacon_ad[] = {
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, (sizeof(CONFIG_BT_DEVICE_NAME) - 1)),
+    BT_DATA(BT_DATA_MANUFACTURER_DATA, mfr_data, sizeof(mfr_data)),
+};
+
+/* The periodic train is only read by synced scanners, which already know
+ * the device, so it carries the readings alone.
+ */
+static const struct bt_data beacon_per_ad[] = {
+    BT_DATA(BT_DATA_MANUFACTURER_DATA, mfr_data, sizeof(mfr_data)),
+};
+
+static int beacon_set_data(void) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memcpy(&mfr_data[2], latest, SNAPSHOT_LEN);
+    last_update_ms = k_uptime_get();
+    k_spin_unlock(&lock, key);
+
+    int err = bt_le_ext_adv_set_data(adv, beacon_ad, ARRAY_SIZE(beacon_ad), NULL, 0);
+    if (err) return err;
+
+    return bt_le_per_adv_set_data(adv, beacon_per_ad, ARRAY_SIZE(beacon_per_ad));
+}
+
+int ble_beacon_init(void) {
+    const struct bt_le_adv_param param =
+        BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_EXT_ADV, BEACON_ADV_INTERVAL, BEACON_ADV_INTERVAL, NULL);
+    const struct bt_le_per_adv_param per_param =
+        BT_LE_PER_ADV_PARAM_INIT(BEACON_PER_INTERVAL, BEACON_PER_INTERVAL, BT_LE_PER_ADV_OPT_NONE);
+    int err;
+
+    sys_put_le16(BLE_BEACON_COMPANY_ID, &mfr_data[0]);
+
+    k_work_queue_start(&beacon_q, beacon_stack, K_THREAD_STACK_SIZEOF(beacon_stack),
+                       BEACON_PRIORITY, NULL);
+    k_thread_name_set(&beacon_q.thread, "beacon");
+
+    err = bt_le_ext_adv_create(&param, NULL, &adv);
+    if (err) return err;
+
+    err = bt_le_per_adv_set_param(adv, &per_param);
+    if (err) return err;
+
+    if (IS_ENABLED(CONFIG_BLE_BEACON_DEFAULT)) {
+        ble_beacon_request(true);
+    }
+    return 0;
+}
+
+static int beacon_set_enabled(bool enable) {
+    int err;
+
+    if (!adv) return -ENODEV;
+    if (enable == enabled) return 0;
+
+    if (enable) {
+        /* Whatever the snapshot held when broadcasting stopped, until
+         * the next sample replaces it
+         */
+        err = beacon_set_data();
+        if (err) return err;
+
+        err = bt_le_per_adv_start(adv);
+        if (err) return err;
+
+        err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
+        if (err) {
+            bt_le_per_adv_stop(adv);
+            return err;
+        }
+    } else {
+        bt_le_per_adv_stop(adv);
+        err = bt_le_ext_adv_stop(adv);
+        if (err) return err;
+    }
+
+    enabled = enable;
+    printk("Beacon %s\n", enable ? "on" : "off");
+    return 0;
+}
+
+static void switch_handler(struct k_work *work) {
+    int err = beacon_set_enabled(atomic_get(&enable_request));
+    if (err) printk("Beacon switch failed (err %d)\n", err);
+}
+
+void ble_beacon_request(bool enable) {
+    atomic_set(&enable_request, enable);
+    k_work_submit_to_queue(&beacon_q, &switch_work);
+}
+
+bool ble_beacon_is_enabled(void) {
+    return enabled;
+}
+
+static void update_handler(struct k_work *work) {
+    if (!enabled) return;
+
+    int err = beacon_set_data();
+    if (err) printk("Beacon update failed (err %d)\n", err);
+}
+
+/* Scanners see at most one payload per advertising interval, so updates
+ * closer than that are folded into the next one (latest wins)
+ */
+void ble_beacon_update(const uint8_t *snapshot) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t due = last_update_ms + CONFIG_BLE_BEACON_INTERVAL_MS;
+    int64_t now = k_uptime_get();
+
+    memcpy(latest, snapshot, SNAPSHOT_LEN);
+    k_spin_unlock(&lock, key);
+
+    if (!adv) return;
+
+    /* Keeps an update already scheduled, which then sends this snapshot */
+    k_work_schedule_for_queue(&beacon_q, &update_work, due > now ? K_MSEC(due - now) : K_NO_WAIT);
+}
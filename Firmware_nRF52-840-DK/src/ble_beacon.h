@@ -0,0 +1,43 @@
+#ifndef BLE_BEACON_H
+#define BLE_BEACON_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/* Connectionless broadcast of the latest snapshot. A non-connectable
+ * extended advertising set carries it as manufacturer specific data,
+ * little endian:
+ *  0  u16  company id BLE_BEACON_COMPANY_ID
+ *  2       snapshot record (SNAPSHOT_LEN bytes, see snapshot.h)
+ * and the periodic advertising train of the same set repeats it, so a
+ * synced scanner gets every update without scanning continuously. The
+ * snapshot sequence number tells repeats from new readings.
+ */
+#define BLE_BEACON_COMPANY_ID 0xffff  /* Bluetooth SIG id reserved for testing */
+
+/**
+ * @brief Creates the advertising set and starts the beacon work queue.
+ *        Call after bt_enable(); broadcasting starts if
+ *        CONFIG_BLE_BEACON_DEFAULT is set.
+ * @return 0 on success, negative error code otherwise.
+ */
+int ble_beacon_init(void);
+
+/**
+ * @brief Starts or stops broadcasting on the beacon work queue; callable
+ *        from any thread, Bluetooth callbacks included. Connectable
+ *        advertising and open connections are not affected.
+ */
+void ble_beacon_request(bool enable);
+
+bool ble_beacon_is_enabled(void);
+
+/**
+ * @brief Replaces the broadcast payload with an encoded snapshot
+ *        (SNAPSHOT_LEN bytes). Never blocks: the advertising data is
+ *        rewritten on the beacon work queue, at most once per
+ *        CONFIG_BLE_BEACON_INTERVAL_MS, with the newest snapshot.
+ */
+void ble_beacon_update(const uint8_t *snapshot);
+
+#endif
@@ -5,27 +5,150 @@
 #include <bluetooth/gatt.h>
 #include <bluetooth/uuid.h>
 #include <sys/printk.h>
+#include <sys/byteorder.h>
 #include <string.h>
 #include <drivers/sensor.h>
 #include "ble_manager.h"
+#include "sample_ring.h"
+#include "snapshot.h"
+#include "sample_store.h"
+#include "ble_beacon.h"
+#include "diag.h"
+#include "histo.h"
+#include "energy.h"
 
-static struct bt_conn *current_conn;
+/* Characteristic payload sizes */
+#define GAS_PAYLOAD_LEN   20
+#define ENV_PAYLOAD_LEN   8
+#define SND_PAYLOAD_LEN   12
 
-/* Data Buffers */
-static uint8_t sensor_data_buffer[20];
-static uint8_t temp_hum_buffer[8];
-static uint8_t sound_buffer[4];
-static uint32_t sound_counter = 0;
+static struct sample_consumer ble_consumer;
+static struct snapshot_state snapshot;
+
+/* Notification channels of one central. Each holds at most one pending
+ * frame; a newer update replaces it (latest wins), so a slow link costs
+ * staleness, never queue growth.
+ */
+enum tx_chan {
+    TX_SNAP,
+#ifdef CONFIG_BLE_LEGACY_CHARS
+    TX_GAS,
+    TX_ENV,
+    TX_SND,
+#endif
+    TX_CHAN_COUNT
+};
+
+struct tx_slot {
+    uint16_t len;
+    uint8_t records;  /* snapshot records in the frame, 1 for single updates */
+    bool pending;
+    uint32_t sample_cyc;  /* acquisition cycle stamp of the newest reading, 0 if none */
+    uint8_t buf[SNAPSHOT_BATCH_LEN(SNAPSHOT_BATCH_MAX)];
+};
+
+static atomic_t tx_sent;
+static atomic_t tx_coalesced;
+static atomic_t tx_dropped;
+
+#define TX_RETRY_MS 50
+
+#ifdef CONFIG_SAMPLE_STORE
+/* Backlog download state of one central */
+struct log_dump {
+    struct sample_store_cursor cur;
+    atomic_t requested;  /* set by the write, taken by the work item */
+    uint32_t from_seq;
+    uint8_t buf[SAMPLE_STORE_BLOCK_MAX];
+    uint16_t len;        /* block read but not yet sent */
+    bool active;
+    bool end;
+};
+#endif
+
+/* One entry per connection slot, indexed by bt_conn_index(). conn is
+ * swapped atomically by the connection callbacks (BT RX thread); the work
+ * items on the system work queue only load it. The reference taken on
+ * connection is dropped by reset_work on that same queue, so a work item
+ * that loaded the pointer can use it until it returns, and the slot is
+ * not handed to a new connection before its stream state is cleared.
+ * Subscriptions themselves are tracked per connection by the CCC
+ * descriptors.
+ */
+struct ble_peer {
+    atomic_ptr_t conn;
+    struct bt_conn *closing;  /* disconnected, released by reset_work */
+    struct k_work reset_work;
+    atomic_t in_flight;  /* notifications handed to the stack, not yet sent */
+    atomic_t gen;        /* bumped per connection, tags its notifications */
+    struct tx_slot tx[TX_CHAN_COUNT];
+    /* Reading stamps of the frames in flight, for the notify histogram */
+    uint32_t tx_cyc[CONFIG_BLE_TX_IN_FLIGHT];
+    uint8_t tx_cyc_head;
+    struct k_work_delayable tx_work;
+    /* Records per notification requested by this central; 0 or 1 sends
+     * every snapshot as it is produced.
+     */
+    atomic_t batch_target;
+    struct snapshot_batch batch;
+    uint32_t batch_cyc;  /* stamp of the newest record in the batch */
+    struct k_work_delayable batch_flush_work;
+    struct k_work setup_work;
+#ifdef CONFIG_SAMPLE_STORE
+    struct log_dump dump;
+#endif
+    /* Snapshot served to this central's reads, taken at offset 0 so a
+     * long read never mixes two records (BT RX thread only)
+     */
+    uint8_t snap_read[SNAPSHOT_LEN];
+#ifdef CONFIG_APP_DIAG
+    /* Same for the diagnostics, which take several reads at any MTU */
+    uint8_t diag_read[DIAG_LEN(CONFIG_APP_DIAG_MAX_THREADS)];
+    uint16_t diag_read_len;
+#endif
+#ifdef CONFIG_APP_HISTO
+    uint8_t histo_read[HISTO_LEN];
+#endif
+#ifdef CONFIG_APP_POWER
+    struct k_work_delayable params_work;
+    int8_t live;  /* connection parameters last requested, -1 none yet */
+#endif
+};
+
+static struct ble_peer peers[CONFIG_BT_MAX_CONN];
+
+static const struct bt_gatt_attr *tx_attrs[TX_CHAN_COUNT];
+
+static inline struct ble_peer *peer_of(struct bt_conn *conn) {
+    return &peers[bt_conn_index(conn)];
+}
+
+/* Valid until the calling work item returns; see struct ble_peer */
+static inline struct bt_conn *peer_conn(struct ble_peer *peer) {
+    return atomic_ptr_get(&peer->conn);
+}
 
 #define BT_UUID_GAS_SERVICE_VAL BT_UUID_128_ENCODE(0x47617353, 0x656e, 0x736f, 0x7253, 0x766300000000)
 #define BT_UUID_GAS_CHAR_VAL    BT_UUID_128_ENCODE(0x47617352, 0x6561, 0x6469, 0x6e67, 0x730000000000)
 #define BT_UUID_ENV_CHAR_VAL    BT_UUID_128_ENCODE(0x456e7669, 0x726f, 0x6e6d, 0x656e, 0x740000000000)
 #define BT_UUID_SND_CHAR_VAL    BT_UUID_128_ENCODE(0x536f756e, 0x6444, 0x6574, 0x6563, 0x740000000000)
+#define BT_UUID_SNAP_CHAR_VAL   BT_UUID_128_ENCODE(0x536e6170, 0x7368, 0x6f74, 0x5631, 0x000000000000)
+#define BT_UUID_MODE_CHAR_VAL   BT_UUID_128_ENCODE(0x4e6f7469, 0x6679, 0x4d6f, 0x6465, 0x000000000000)
+#define BT_UUID_LOG_CHAR_VAL    BT_UUID_128_ENCODE(0x4c6f6744, 0x756d, 0x7056, 0x3100, 0x000000000000)
+#define BT_UUID_BEACON_CHAR_VAL BT_UUID_128_ENCODE(0x42656163, 0x6f6e, 0x4d6f, 0x6465, 0x000000000000)
+#define BT_UUID_DIAG_CHAR_VAL   BT_UUID_128_ENCODE(0x44696167, 0x6e6f, 0x7374, 0x6963, 0x730000000000)
+#define BT_UUID_HISTO_CHAR_VAL  BT_UUID_128_ENCODE(0x48697374, 0x6f67, 0x7261, 0x6d73, 0x000000000000)
 
 static struct bt_uuid_128 gas_service_uuid = BT_UUID_INIT_128(BT_UUID_GAS_SERVICE_VAL);
 static struct bt_uuid_128 gas_char_uuid = BT_UUID_INIT_128(BT_UUID_GAS_CHAR_VAL);
 static struct bt_uuid_128 env_char_uuid = BT_UUID_INIT_128(BT_UUID_ENV_CHAR_VAL);
 static struct bt_uuid_128 snd_char_uuid = BT_UUID_INIT_128(BT_UUID_SND_CHAR_VAL);
+static struct bt_uuid_128 snap_char_uuid = BT_UUID_INIT_128(BT_UUID_SNAP_CHAR_VAL);
+static struct bt_uuid_128 mode_char_uuid = BT_UUID_INIT_128(BT_UUID_MODE_CHAR_VAL);
+static struct bt_uuid_128 log_char_uuid = BT_UUID_INIT_128(BT_UUID_LOG_CHAR_VAL);
+static struct bt_uuid_128 beacon_char_uuid = BT_UUID_INIT_128(BT_UUID_BEACON_CHAR_VAL);
+static struct bt_uuid_128 diag_char_uuid = BT_UUID_INIT_128(BT_UUID_DIAG_CHAR_VAL);
+static struct bt_uuid_128 histo_char_uuid = BT_UUID_INIT_128(BT_UUID_HISTO_CHAR_VAL);
 
 /* Advertising data must be static/global to be constant */
 static const struct bt_data ad[] = {
@@ -37,20 +160,322 @@ static const struct bt_data sd[] = {
     BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, (sizeof(CONFIG_BT_DEVICE_NAME) - 1)),
 };
 
+#ifdef CONFIG_BLE_LEGACY_CHARS
+/* Payloads are packed from a private copy of the record, never from a
+ * buffer the acquisition side writes to.
+ */
+static uint16_t pack_sample(const struct sample *smp, uint8_t *buf) {
+    switch (smp->kind) {
+    case SAMPLE_GAS:
+        memcpy(&buf[0], &smp->gas.co, 4);
+        memcpy(&buf[4], &smp->gas.no2, 4);
+        memcpy(&buf[8], &smp->gas.nh3, 4);
+        memcpy(&buf[12], &smp->gas.ch4, 4);
+        memcpy(&buf[16], &smp->gas.etoh, 4);
+        return GAS_PAYLOAD_LEN;
+    case SAMPLE_ENV:
+        memcpy(&buf[0], &smp->env.temp_c, 4);
+        memcpy(&buf[4], &smp->env.hum_pct, 4);
+        return ENV_PAYLOAD_LEN;
+    case SAMPLE_SOUND:
+        sys_put_le32(smp->sound.start_ms, &buf[0]);
+        sys_put_le16(smp->sound.events, &buf[4]);
+        sys_put_le16(smp->sound.peak_rate_dhz, &buf[6]);
+        sys_put_le16(smp->sound.first_ms, &buf[8]);
+        sys_put_le16(smp->sound.last_ms, &buf[10]);
+        return SND_PAYLOAD_LEN;
+    default:
+        return 0;
+    }
+}
+
+static ssize_t read_latest(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                           uint16_t len, uint16_t offset, enum sample_kind kind, uint16_t size) {
+    struct sample smp;
+    uint8_t value[GAS_PAYLOAD_LEN] = {0};
+
+    if (sample_ring_latest(kind, &smp) == 0) {
+        pack_sample(&smp, value);
+    }
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, value, size);
+}
+
 static ssize_t read_gas_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, sensor_data_buffer, sizeof(sensor_data_buffer));
+    return read_latest(conn, attr, buf, len, offset, SAMPLE_GAS, GAS_PAYLOAD_LEN);
 }
 
 static ssize_t read_env_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, temp_hum_buffer, sizeof(temp_hum_buffer));
+    return read_latest(conn, attr, buf, len, offset, SAMPLE_ENV, ENV_PAYLOAD_LEN);
 }
 
 static ssize_t read_snd_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, sound_buffer, sizeof(sound_buffer));
+    return read_latest(conn, attr, buf, len, offset, SAMPLE_SOUND, SND_PAYLOAD_LEN);
+}
+#endif /* CONFIG_BLE_LEGACY_CHARS */
+
+static ssize_t read_snap_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    struct ble_peer *peer = peer_of(conn);
+
+    if (offset == 0) {
+        struct snapshot_state st = { .seq = snapshot.seq };
+
+        snapshot_from_ring(&st);
+        snapshot_encode(&st, peer->snap_read);
+    }
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, peer->snap_read, sizeof(peer->snap_read));
+}
+
+static ssize_t read_mode_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    uint8_t value = (uint8_t)atomic_get(&peer_of(conn)->batch_target);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &value, sizeof(value));
+}
+
+static ssize_t write_mode_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+    uint8_t value;
+
+    if (offset) return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    if (len != sizeof(value)) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+    value = *(const uint8_t *)buf;
+    if (value > SNAPSHOT_BATCH_MAX) return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+
+    atomic_set(&peer_of(conn)->batch_target, value);
+    printk("Notify batch size %u (conn %u)\n", value, bt_conn_index(conn));
+#ifdef CONFIG_APP_POWER
+    k_work_reschedule(&peer_of(conn)->params_work, K_NO_WAIT);
+#endif
+    return len;
+}
+
+#ifdef CONFIG_SAMPLE_STORE
+/* Backlog download: the central writes the first log sequence number it
+ * is missing and gets every stored block from there as notifications,
+ * then an end frame (u8 0, u32 next log seq).
+ */
+#define LOG_END_FRAME_LEN 5
+
+static const struct bt_gatt_attr *log_attr;
+
+static ssize_t read_log_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    uint32_t first, next;
+    uint8_t value[8];
+
+    sample_store_range(&first, &next);
+    sys_put_le32(first, &value[0]);
+    sys_put_le32(next, &value[4]);
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
+static ssize_t write_log_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+    if (offset) return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    if (len != sizeof(uint32_t)) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+    struct ble_peer *peer = peer_of(conn);
+
+    peer->dump.from_seq = sys_get_le32(buf);
+    atomic_set(&peer->dump.requested, 1);
+    k_work_reschedule(&peer->tx_work, K_NO_WAIT);
+    return len;
+}
+#endif /* CONFIG_SAMPLE_STORE */
+
+#ifdef CONFIG_BLE_BEACON
+/* Broadcast switch: applied on the beacon work queue, since advertising
+ * set changes block on HCI commands.
+ */
+static ssize_t read_beacon_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    uint8_t value = ble_beacon_is_enabled();
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &value, sizeof(value));
+}
+
+static ssize_t write_beacon_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+    uint8_t value;
+
+    if (offset) return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    if (len != sizeof(value)) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+    value = *(const uint8_t *)buf;
+    if (value > 1) return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+
+    ble_beacon_request(value);
+    return len;
 }
+#endif /* CONFIG_BLE_BEACON */
+
+#ifdef CONFIG_APP_DIAG
+/* Diagnostics (diag.h layout) are copied from the last refresh when a
+ * read starts at offset 0; encoding them here would scan every stack on
+ * the BT RX thread. The rest of a long read is served from the same
+ * per-central copy, so it stays consistent while another central reads
+ * too.
+ */
+static ssize_t read_diag_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    struct ble_peer *peer = peer_of(conn);
+
+    if (offset == 0) {
+        peer->diag_read_len = diag_latest(peer->diag_read, sizeof(peer->diag_read));
+    }
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, peer->diag_read, peer->diag_read_len);
+}
+#endif /* CONFIG_APP_DIAG */
+
+#ifdef CONFIG_APP_HISTO
+/* Same per-central snapshot-at-offset-0 scheme as the diagnostics */
+static ssize_t read_histo_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset) {
+    struct ble_peer *peer = peer_of(conn);
+
+    if (offset == 0) {
+        histo_encode(peer->histo_read, sizeof(peer->histo_read));
+    }
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, peer->histo_read, sizeof(peer->histo_read));
+}
+
+static ssize_t write_histo_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+    if (offset) return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    if (len != 1) return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    if (*(const uint8_t *)buf != 0) return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+
+    histo_reset();
+    return len;
+}
+#endif /* CONFIG_APP_HISTO */
+
+/* Advertising interval in effect, for the energy model */
+static uint32_t adv_interval_us = BT_GAP_ADV_FAST_INT_MIN_2 * 625;
+
+/* Connectable advertising runs while a connection slot is free */
+static void adv_account(void) {
+    bool free_slot = false;
+
+    for (int i = 0; i < ARRAY_SIZE(peers); i++) {
+        free_slot |= !peer_conn(&peers[i]);
+    }
+    energy_radio_set(ENERGY_SLOT_ADV, free_slot ? adv_interval_us : 0);
+}
+
+#ifdef CONFIG_APP_POWER
+#define CONN_UNITS(ms) ((ms) * 4 / 5)    /* 1.25 ms */
+#define ADV_UNITS(ms)  ((ms) * 8 / 5)    /* 0.625 ms */
+
+/* The supervision timeout must exceed two effective intervals and is at
+ * most 32 s
+ */
+BUILD_ASSERT(2 * (1 + CONFIG_APP_POWER_CONN_IDLE_LATENCY) * CONFIG_APP_POWER_CONN_IDLE_MS < 32000,
+             "APP_POWER_CONN_IDLE_MS x (1 + APP_POWER_CONN_IDLE_LATENCY) must stay below 16 s");
+
+/* A refused update is retried after this, not on every snapshot */
+#define PARAMS_RETRY_S 10
+
+/* Whether this central should get the live (short) connection interval */
+static bool peer_wants_live(struct ble_peer *peer, struct bt_conn *conn) {
+    return bt_gatt_is_subscribed(conn, tx_attrs[TX_SNAP], BT_GATT_CCC_NOTIFY) &&
+           atomic_get(&peer->batch_target) < 2;
+}
+
+/* Live streaming keeps a short connection interval for latency. Batched
+ * or unsubscribed centrals get a long one plus peripheral latency, which
+ * the link only uses while there is nothing to send.
+ */
+static void params_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct ble_peer *peer = CONTAINER_OF(dwork, struct ble_peer, params_work);
+    struct bt_conn *conn = peer_conn(peer);
+
+    if (!conn) return;
+
+    bool live = peer_wants_live(peer, conn);
+
+    if (peer->live == live) return;
+
+    uint16_t interval = CONN_UNITS(live ? CONFIG_APP_POWER_CONN_LIVE_MS : CONFIG_APP_POWER_CONN_IDLE_MS);
+    uint16_t latency = live ? 0 : CONFIG_APP_POWER_CONN_IDLE_LATENCY;
+    uint32_t effective_ms = (1 + latency) * interval * 5 / 4;
+    /* Supervision timeout, 10 ms units: three effective intervals, 4..32 s,
+     * which stays above two of them given the BUILD_ASSERT
+     */
+    uint16_t timeout = CLAMP(effective_ms * 3 / 10, 400, 3200);
+    int err = bt_conn_le_param_update(conn, BT_LE_CONN_PARAM(interval, interval, latency, timeout));
+
+    if (err) {
+        printk("Conn param update failed (err %d), retry in %u s\n", err, PARAMS_RETRY_S);
+        k_work_schedule(dwork, K_SECONDS(PARAMS_RETRY_S));
+        return;
+    }
+    peer->live = live;
+}
+
+static void snap_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value) {
+    for (int i = 0; i < ARRAY_SIZE(peers); i++) {
+        if (peer_conn(&peers[i])) {
+            k_work_reschedule(&peers[i].params_work, K_NO_WAIT);
+        }
+    }
+}
+
+/* Fast advertising for CONFIG_APP_POWER_ADV_FAST_S after boot and after
+ * every disconnection so a central finds the node quickly, slow after
+ * that. The host keeps resuming it with the last parameters.
+ */
+static atomic_t adv_fast_request;
+
+static int adv_start(bool fast) {
+    uint16_t min = fast ? BT_GAP_ADV_FAST_INT_MIN_2 : ADV_UNITS(CONFIG_APP_POWER_ADV_SLOW_MS);
+    uint16_t max = fast ? BT_GAP_ADV_FAST_INT_MAX_2 : min + min / 5;
+    int err;
+
+    bt_le_adv_stop();
+    err = bt_le_adv_start(BT_LE_ADV_PARAM(BT_LE_ADV_OPT_CONNECTABLE, min, max, NULL), ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    if (!err) {
+        adv_interval_us = min * 625;
+        adv_account();
+    }
+    return err;
+}
+
+static void adv_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    bool fast = atomic_cas(&adv_fast_request, 1, 0);
+    int err = adv_start(fast);
+
+    /* With every slot taken the host resumes it after a disconnection */
+    if (err && err != -ENOMEM) printk("Advertising restart failed (err %d)\n", err);
+    if (fast) k_work_schedule(dwork, K_SECONDS(CONFIG_APP_POWER_ADV_FAST_S));
+}
+
+static K_WORK_DELAYABLE_DEFINE(adv_work, adv_handler);
+
+#define SNAP_CCC_CHANGED snap_ccc_changed
+#else
+#define SNAP_CCC_CHANGED NULL
+#endif /* CONFIG_APP_POWER */
 
 BT_GATT_SERVICE_DEFINE(gas_svc,
     BT_GATT_PRIMARY_SERVICE(&gas_service_uuid),
+    /* Combined fixed-point snapshot */
+    BT_GATT_CHARACTERISTIC(&snap_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ, read_snap_cb, NULL, NULL),
+    BT_GATT_CCC(SNAP_CCC_CHANGED, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    /* Snapshot records per notification (0/1 = live) */
+    BT_GATT_CHARACTERISTIC(&mode_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE, read_mode_cb, write_mode_cb, NULL),
+#ifdef CONFIG_SAMPLE_STORE
+    /* Flash log range (read) and backlog download (write seq, notify) */
+    BT_GATT_CHARACTERISTIC(&log_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE, read_log_cb, write_log_cb, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+#endif
+#ifdef CONFIG_BLE_BEACON
+    /* Snapshot broadcast in advertising, 0 = off, 1 = on */
+    BT_GATT_CHARACTERISTIC(&beacon_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE, read_beacon_cb, write_beacon_cb, NULL),
+#endif
+#ifdef CONFIG_APP_DIAG
+    /* Thread CPU and stack usage, queue depths (read only, long read) */
+    BT_GATT_CHARACTERISTIC(&diag_char_uuid.uuid, BT_GATT_CHRC_READ, BT_GATT_PERM_READ, read_diag_cb, NULL, NULL),
+#endif
+#ifdef CONFIG_APP_HISTO
+    /* Period, bus and notify latency histograms (long read), write 0 to clear */
+    BT_GATT_CHARACTERISTIC(&histo_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE, read_histo_cb, write_histo_cb, NULL),
+#endif
+#ifdef CONFIG_BLE_LEGACY_CHARS
     /* Gas Characteristic */
     BT_GATT_CHARACTERISTIC(&gas_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ, read_gas_cb, NULL, NULL),
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
@@ -60,65 +485,506 @@ BT_GATT_SERVICE_DEFINE(gas_svc,
     /* Sound Detected Characteristic */
     BT_GATT_CHARACTERISTIC(&snd_char_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ, read_snd_cb, NULL, NULL),
     BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+#endif
 );
 
 static void connected(struct bt_conn *conn, uint8_t err) {
     if (err) {
         printk("Connection failed (err %u)\n", err);
-    } else {
-        printk("Connected\n");
-        current_conn = bt_conn_ref(conn);
+        return;
     }
+
+    struct ble_peer *peer = peer_of(conn);
+    struct bt_conn_info info;
+
+    printk("Connected (conn %u)\n", bt_conn_index(conn));
+    atomic_set(&peer->batch_target, CONFIG_BLE_BATCH_DEFAULT);
+    /* Completions still due from the previous connection on this slot
+     * carry the old generation and are ignored by tx_done()
+     */
+    atomic_inc(&peer->gen);
+    atomic_set(&peer->in_flight, 0);
+#ifdef CONFIG_APP_POWER
+    peer->live = -1;
+#endif
+    atomic_ptr_set(&peer->conn, bt_conn_ref(conn));
+    k_work_submit(&peer->setup_work);
+
+    if (!bt_conn_get_info(conn, &info)) {
+        energy_radio_set(ENERGY_SLOT_CONN(bt_conn_index(conn)), info.le.interval * 1250);
+    }
+    adv_account();
 }
 
+/* Advertising is not one-time, so the host resumes it by itself while a
+ * connection slot is free.
+ */
 static void disconnected(struct bt_conn *conn, uint8_t reason) {
-    printk("Disconnected (reason %u)\n", reason);
-    if (current_conn) {
-        bt_conn_unref(current_conn);
-        current_conn = NULL;
+    struct ble_peer *peer = peer_of(conn);
+
+    printk("Disconnected (conn %u, reason %u)\n", bt_conn_index(conn), reason);
+
+    /* The stream state belongs to the work queue, so it is torn down
+     * there, after any work item still holding the old connection
+     */
+    peer->closing = atomic_ptr_set(&peer->conn, NULL);
+    k_work_submit(&peer->reset_work);
+
+    energy_radio_set(ENERGY_SLOT_CONN(bt_conn_index(conn)), 0);
+    adv_account();
+#ifdef CONFIG_APP_POWER
+    atomic_set(&adv_fast_request, 1);
+    k_work_reschedule(&adv_work, K_NO_WAIT);
+#endif
+}
+
+static void le_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info) {
+    printk("Data length tx %u/%uus rx %u/%uus\n", info->tx_max_len, info->tx_max_time, info->rx_max_len, info->rx_max_time);
+}
+
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param) {
+    printk("PHY tx %u rx %u\n", param->tx_phy, param->rx_phy);
+}
+
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    printk("Conn params interval %u latency %u timeout %u\n", interval, latency, timeout);
+    /* Peripheral latency counted as always used: nothing to send most of the time */
+    energy_radio_set(ENERGY_SLOT_CONN(bt_conn_index(conn)), interval * 1250 * (latency + 1));
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .le_data_len_updated = le_data_len_updated,
+    .le_phy_updated = le_phy_updated,
+    .le_param_updated = le_param_updated,
+};
+
+/* Ask for the longest LL payload (and 2M PHY) so a full batch leaves in
+ * one radio event instead of being fragmented over several. Runs from the
+ * work queue rather than the connected callback since both wait for HCI.
+ * The ATT MTU is exchanged by the central.
+ */
+static void conn_setup_handler(struct k_work *work) {
+    struct ble_peer *peer = CONTAINER_OF(work, struct ble_peer, setup_work);
+    struct bt_conn *conn = peer_conn(peer);
+    int err;
+
+    if (!conn) return;
+
+    err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (err) printk("Data length update failed (err %d)\n", err);
+
+    if (IS_ENABLED(CONFIG_BLE_BATCH_PHY_2M)) {
+        err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+        if (err) printk("PHY update failed (err %d)\n", err);
     }
+#ifdef CONFIG_APP_POWER
+    params_handler(&peer->params_work.work);
+#endif
 }
 
-BT_CONN_CB_DEFINE(conn_callbacks) = { .connected = connected, .disconnected = disconnected };
+/* Clears what a central left behind and releases its connection. Runs on
+ * the system work queue like every user of this state.
+ */
+static void peer_reset_handler(struct k_work *work) {
+    struct ble_peer *peer = CONTAINER_OF(work, struct ble_peer, reset_work);
+    struct bt_conn *old = peer->closing;
 
-int ble_manager_init(void) {
-    int err = bt_enable(NULL);
-    if (err) return err;
+    /* Nothing of this central's stream carries over to the next one */
+    k_work_cancel_delayable(&peer->batch_flush_work);
+    k_work_cancel_delayable(&peer->tx_work);
+#ifdef CONFIG_APP_POWER
+    k_work_cancel_delayable(&peer->params_work);
+#endif
+    peer->batch.count = 0;
+    for (int i = 0; i < TX_CHAN_COUNT; i++) {
+        peer->tx[i].pending = false;
+    }
+#ifdef CONFIG_SAMPLE_STORE
+    atomic_set(&peer->dump.requested, 0);
+    peer->dump.active = false;
+#endif
 
-    return bt_le_adv_start(BT_LE_ADV_CONN, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    peer->closing = NULL;
+    if (old) {
+        bt_conn_unref(old);
+    }
 }
 
-void ble_update_sensor_data(struct gas_data *data) {
-    memcpy(&sensor_data_buffer[0], &data->co, 4);
-    memcpy(&sensor_data_buffer[4], &data->no2, 4);
-    memcpy(&sensor_data_buffer[8], &data->nh3, 4);
-    memcpy(&sensor_data_buffer[12], &data->ch4, 4);
-    memcpy(&sensor_data_buffer[16], &data->etoh, 4);
+/* Value attributes are looked up by UUID since the legacy ones are optional */
+static const struct bt_gatt_attr *find_value_attr(const struct bt_uuid *uuid) {
+    return bt_gatt_find_by_uuid(gas_svc.attrs, gas_svc.attr_count, uuid);
+}
+
+/* Notification user data: the connection generation, and the index of
+ * the frame's reading stamp in tx_cyc or TX_NO_STAMP
+ */
+#define TX_NO_STAMP           0xffU
+#define TX_TAG(gen, idx)      UINT_TO_POINTER(((uint32_t)(gen) << 8) | (idx))
+#define TX_TAG_GEN(tag)       (POINTER_TO_UINT(tag) >> 8)
+#define TX_TAG_IDX(tag)       (POINTER_TO_UINT(tag) & 0xffU)
+#define TX_GEN_MASK           (UINT32_MAX >> 8)
+
+static void tx_done(struct bt_conn *conn, void *user_data) {
+    struct ble_peer *peer = peer_of(conn);
+    uint32_t idx = TX_TAG_IDX(user_data);
 
-    if (current_conn) {
-        bt_gatt_notify(current_conn, &gas_svc.attrs[1], sensor_data_buffer, sizeof(sensor_data_buffer));
+    /* Sent on an earlier connection of this slot, whose budget is gone */
+    if (TX_TAG_GEN(user_data) != ((uint32_t)atomic_get(&peer->gen) & TX_GEN_MASK)) {
+        return;
     }
+
+    if (idx != TX_NO_STAMP) {
+        histo_add(HISTO(HISTO_NOTIFY), k_cycle_get_32() - peer->tx_cyc[idx]);
+    }
+
+    atomic_dec(&peer->in_flight);
+    atomic_inc(&tx_sent);
+    k_work_reschedule(&peer->tx_work, K_NO_WAIT);
 }
 
-void ble_update_temp_hum(struct sensor_value *temp, struct sensor_value *hum) {
-    float t_val = sensor_value_to_double(temp);
-    float h_val = sensor_value_to_double(hum);
+/* Hands a frame to the stack if this central has budget left. Frames are
+ * only sent while fewer than CONFIG_BLE_TX_IN_FLIGHT are outstanding, so
+ * buffer allocation never blocks the work queue the sensors run on.
+ * @param sample_cyc Acquisition cycle stamp of the newest reading in the
+ *        frame, for the notify latency histogram; 0 when the frame has none.
+ * @return 0 when sent, -EBUSY when out of budget, -ENOMEM when the stack
+ *         is out of buffers, other negative values when it refused the
+ *         frame.
+ */
+static int tx_send(struct ble_peer *peer, struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                   const uint8_t *data, uint16_t len, uint32_t sample_cyc) {
+    uint32_t idx = TX_NO_STAMP;
+    int err;
 
-    memcpy(&temp_hum_buffer[0], &t_val, 4);
-    memcpy(&temp_hum_buffer[4], &h_val, 4);
+    if (atomic_get(&peer->in_flight) >= CONFIG_BLE_TX_IN_FLIGHT) {
+        return -EBUSY;
+    }
 
-    if (current_conn) {
-        /* Index 1 is Gas, 2 is Gas CCC, 3 is Env Char, 4 is Env CCC... wait.
-           Service=0, GasCharDef=1, GasVal=2, GasCCC=3. EnvCharDef=4, EnvVal=5, EnvCCC=6. SndCharDef=7, SndVal=8, SndCCC=9. */
-        bt_gatt_notify(current_conn, &gas_svc.attrs[5], temp_hum_buffer, sizeof(temp_hum_buffer));
+    /* Completions come back in order, so with the in-flight budget a
+     * stamp is not overwritten before its frame is done
+     */
+    if (sample_cyc) {
+        idx = peer->tx_cyc_head;
+        peer->tx_cyc[idx] = sample_cyc;
+        peer->tx_cyc_head = (idx + 1) % CONFIG_BLE_TX_IN_FLIGHT;
     }
+
+    struct bt_gatt_notify_params params = {
+        .attr = attr,
+        .data = data,
+        .len = len,
+        .func = tx_done,
+        .user_data = TX_TAG((uint32_t)atomic_get(&peer->gen) & TX_GEN_MASK, idx),
+    };
+
+    atomic_inc(&peer->in_flight);
+    err = bt_gatt_notify_cb(conn, &params);
+    if (err) {
+        atomic_dec(&peer->in_flight);
+        if (idx != TX_NO_STAMP) {
+            peer->tx_cyc_head = idx;
+        }
+    } else {
+        energy_radio_tx(len);
+    }
+    return err;
+}
+
+/* Stores the newest frame of a channel, replacing one not sent yet */
+static void tx_post(struct ble_peer *peer, enum tx_chan chan, const uint8_t *data, uint16_t len,
+                    uint8_t records, uint32_t sample_cyc) {
+    struct tx_slot *slot = &peer->tx[chan];
+
+    if (slot->pending) {
+        if (slot->records > 1) {
+            /* A batch carries history the newer frame does not have */
+            atomic_add(&tx_dropped, slot->records);
+        } else {
+            atomic_inc(&tx_coalesced);
+        }
+    }
+
+    memcpy(slot->buf, data, len);
+    slot->len = len;
+    slot->records = records;
+    slot->sample_cyc = sample_cyc;
+    slot->pending = true;
+    k_work_reschedule(&peer->tx_work, K_NO_WAIT);
+}
+
+#ifdef CONFIG_SAMPLE_STORE
+/* Sends backlog blocks with whatever budget the live channels left.
+ * @return 0, or the error that stopped it.
+ */
+static int dump_step(struct ble_peer *peer, struct bt_conn *conn) {
+    struct log_dump *dump = &peer->dump;
+
+    if (atomic_cas(&dump->requested, 1, 0)) {
+        sample_store_flush();
+        sample_store_cursor_init(&dump->cur, dump->from_seq);
+        dump->len = 0;
+        dump->end = false;
+        dump->active = true;
+        printk("Log download from %u\n", dump->from_seq);
+    }
+
+    while (dump->active) {
+        if (!dump->len) {
+            int len = sample_store_next(&dump->cur, dump->buf, sizeof(dump->buf));
+
+            if (len < 0) {
+                printk("Log read failed (err %d)\n", len);
+                dump->active = false;
+                return len;
+            }
+            if (len == 0) {
+                uint32_t first, next;
+
+                sample_store_range(&first, &next);
+                dump->buf[0] = 0;
+                sys_put_le32(next, &dump->buf[1]);
+                len = LOG_END_FRAME_LEN;
+                dump->end = true;
+            }
+            dump->len = len;
+        }
+
+        int err = tx_send(peer, conn, log_attr, dump->buf, dump->len, 0);
+
+        if (err == -EBUSY || err == -ENOMEM) {
+            return err;
+        }
+        if (err) {
+            printk("Log notify failed (err %d)\n", err);
+            dump->active = false;
+            return err;
+        }
+
+        dump->len = 0;
+        if (dump->end) {
+            dump->active = false;
+        }
+    }
+    return 0;
 }
+#endif /* CONFIG_SAMPLE_STORE */
+
+/* Transmit stage of one central: pending live frames first, then the
+ * backlog download. Runs again from every completion; buffers taken by
+ * another central are retried after TX_RETRY_MS.
+ */
+static void tx_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct ble_peer *peer = CONTAINER_OF(dwork, struct ble_peer, tx_work);
+    struct bt_conn *conn = peer_conn(peer);
 
-void ble_update_sound(void) {
-    sound_counter++;
-    memcpy(sound_buffer, &sound_counter, 4);
+    if (!conn) {
+        return;
+    }
+
+    for (int chan = 0; chan < TX_CHAN_COUNT; chan++) {
+        struct tx_slot *slot = &peer->tx[chan];
+
+        if (!slot->pending) {
+            continue;
+        }
+
+        int err = tx_send(peer, conn, tx_attrs[chan], slot->buf, slot->len, slot->sample_cyc);
+
+        if (err == -EBUSY) {
+            return;
+        }
+        if (err == -ENOMEM) {
+            k_work_schedule(dwork, K_MSEC(TX_RETRY_MS));
+            return;
+        }
+        if (err) {
+            atomic_add(&tx_dropped, slot->records);
+        }
+        slot->pending = false;
+    }
 
-    if (current_conn) {
-        bt_gatt_notify(current_conn, &gas_svc.attrs[8], sound_buffer, sizeof(sound_buffer));
+#ifdef CONFIG_SAMPLE_STORE
+    if (dump_step(peer, conn) == -ENOMEM) {
+        k_work_schedule(dwork, K_MSEC(TX_RETRY_MS));
     }
-}
\ No newline at end of file
+#endif
+}
+
+/* Records that fit one notification at the negotiated MTU, capped by
+ * what the central asked for.
+ */
+static uint8_t batch_limit(struct ble_peer *peer, struct bt_conn *conn) {
+    uint8_t target = (uint8_t)atomic_get(&peer->batch_target);
+    uint16_t payload = bt_gatt_get_mtu(conn) - 3;
+    uint8_t fit = payload < SNAPSHOT_BATCH_LEN(1) ? 0 : (payload - SNAPSHOT_BATCH_HDR_LEN) / SNAPSHOT_LEN;
+
+    return MIN(target, fit);
+}
+
+static void batch_flush(struct ble_peer *peer) {
+    uint8_t records = peer->batch.count;
+    uint16_t len = snapshot_batch_take(&peer->batch);
+
+    k_work_cancel_delayable(&peer->batch_flush_work);
+    if (len && peer_conn(peer)) {
+        tx_post(peer, TX_SNAP, peer->batch.buf, len, records, peer->batch_cyc);
+    }
+}
+
+static void batch_flush_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+
+    batch_flush(CONTAINER_OF(dwork, struct ble_peer, batch_flush_work));
+}
+
+/* Queues the snapshot for one central on its own, or appends it to that
+ * central's batch and queues the batch once it is full. A partial batch
+ * goes out after CONFIG_BLE_BATCH_MAX_AGE_MS so readings are never held
+ * indefinitely.
+ */
+static void send_snapshot(struct ble_peer *peer, struct bt_conn *conn, const uint8_t *value,
+                          uint32_t sample_cyc) {
+    uint8_t limit = batch_limit(peer, conn);
+
+#ifdef CONFIG_APP_POWER
+    /* The CCC callback only fires for the first subscriber. Scheduling
+     * leaves a pending retry delay alone, so a refused update is not
+     * repeated on every snapshot.
+     */
+    if (peer->live != (int8_t)peer_wants_live(peer, conn)) {
+        k_work_schedule(&peer->params_work, K_NO_WAIT);
+    }
+#endif
+
+    if (limit < 2) {
+        batch_flush(peer);
+        tx_post(peer, TX_SNAP, value, SNAPSHOT_LEN, 1, sample_cyc);
+        return;
+    }
+
+    if (peer->batch.count >= limit) {
+        batch_flush(peer);
+    }
+    peer->batch_cyc = sample_cyc;
+    if (snapshot_batch_add(&peer->batch, value) == 1) {
+        k_work_schedule(&peer->batch_flush_work, K_MSEC(CONFIG_BLE_BATCH_MAX_AGE_MS));
+    }
+    if (peer->batch.count >= limit) {
+        batch_flush(peer);
+    }
+}
+
+#ifdef CONFIG_BLE_LEGACY_CHARS
+static const enum tx_chan legacy_chan[SAMPLE_KIND_COUNT] = {
+    [SAMPLE_GAS] = TX_GAS,
+    [SAMPLE_ENV] = TX_ENV,
+    [SAMPLE_SOUND] = TX_SND,
+    [SAMPLE_SOUND_LEVEL] = TX_CHAN_COUNT,
+};
+
+static void send_legacy(const struct sample *smp) {
+    enum tx_chan chan = legacy_chan[smp->kind];
+    uint8_t value[GAS_PAYLOAD_LEN];
+    uint16_t len = pack_sample(smp, value);
+
+    if (!len || chan == TX_CHAN_COUNT) {
+        return;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(peers); i++) {
+        struct bt_conn *conn = peer_conn(&peers[i]);
+
+        if (conn && bt_gatt_is_subscribed(conn, tx_attrs[chan], BT_GATT_CCC_NOTIFY)) {
+            tx_post(&peers[i], chan, value, len, 1, 0);
+        }
+    }
+}
+#endif
+
+/* Ring consumer: drains every new record, then encodes one snapshot for
+ * everything that arrived in the same scheduler tick and hands the same
+ * record to the beacon and to every subscribed central. Only posts into the transmit
+ * slots, so a congested link never holds up the sensor tasks.
+ */
+static void ble_consumer_handler(struct k_work *work) {
+    struct sample smp;
+    bool changed = false;
+    uint32_t newest_cyc = 0;
+
+    while (sample_ring_read(&ble_consumer.reader, &smp) == 0) {
+        if (snapshot_update(&snapshot, &smp)) {
+            changed = true;
+            newest_cyc = smp.stamp_cyc;
+        }
+#ifdef CONFIG_BLE_LEGACY_CHARS
+        send_legacy(&smp);
+#endif
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    uint8_t value[SNAPSHOT_LEN];
+
+    snapshot_encode(&snapshot, value);
+#ifdef CONFIG_BLE_BEACON
+    ble_beacon_update(value);
+#endif
+    for (int i = 0; i < ARRAY_SIZE(peers); i++) {
+        struct bt_conn *conn = peer_conn(&peers[i]);
+
+        if (conn && bt_gatt_is_subscribed(conn, tx_attrs[TX_SNAP], BT_GATT_CCC_NOTIFY)) {
+            send_snapshot(&peers[i], conn, value, newest_cyc);
+        }
+    }
+}
+
+void ble_manager_get_tx_stats(struct ble_tx_stats *stats) {
+    stats->sent = atomic_get(&tx_sent);
+    stats->coalesced = atomic_get(&tx_coalesced);
+    stats->dropped = atomic_get(&tx_dropped);
+}
+
+int ble_manager_init(void) {
+    int err = bt_enable(NULL);
+    if (err) return err;
+
+    tx_attrs[TX_SNAP] = find_value_attr(&snap_char_uuid.uuid);
+#ifdef CONFIG_SAMPLE_STORE
+    log_attr = find_value_attr(&log_char_uuid.uuid);
+#endif
+#ifdef CONFIG_BLE_LEGACY_CHARS
+    tx_attrs[TX_GAS] = find_value_attr(&gas_char_uuid.uuid);
+    tx_attrs[TX_ENV] = find_value_attr(&env_char_uuid.uuid);
+    tx_attrs[TX_SND] = find_value_attr(&snd_char_uuid.uuid);
+#endif
+
+    for (int i = 0; i < ARRAY_SIZE(peers); i++) {
+        k_work_init(&peers[i].reset_work, peer_reset_handler);
+        k_work_init(&peers[i].setup_work, conn_setup_handler);
+        k_work_init_delayable(&peers[i].tx_work, tx_handler);
+        k_work_init_delayable(&peers[i].batch_flush_work, batch_flush_handler);
+#ifdef CONFIG_APP_POWER
+        k_work_init_delayable(&peers[i].params_work, params_handler);
+#endif
+    }
+    sample_ring_subscribe(&ble_consumer, NULL, ble_consumer_handler);
+
+#ifdef CONFIG_BLE_BEACON
+    err = ble_beacon_init();
+    if (err) printk("Beacon init failed (err %d)\n", err);
+#endif
+
+#ifdef CONFIG_APP_POWER
+    k_work_schedule(&adv_work, K_SECONDS(CONFIG_APP_POWER_ADV_FAST_S));
+    return adv_start(true);
+#else
+    err = bt_le_adv_start(BT_LE_ADV_CONN, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    if (!err) adv_account();
+    return err;
+#endif
+}
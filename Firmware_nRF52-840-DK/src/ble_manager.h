@@ -2,12 +2,23 @@
 #define BLE_MANAGER_H
 
 #include <zephyr/types.h>
-#include "gas_sensor.h"
-#include <drivers/sensor.h>
 
+/* Notification transmit counters, summed over all centrals */
+struct ble_tx_stats {
+    uint32_t sent;       /* notifications the stack reported as sent */
+    uint32_t coalesced;  /* pending updates replaced by a newer one */
+    uint32_t dropped;    /* records lost: superseded batches, stack errors */
+};
+
+/**
+ * @brief Enables Bluetooth, subscribes to the sample ring and starts advertising.
+ * @return 0 on success, negative error code otherwise.
+ */
 int ble_manager_init(void);
-void ble_update_sensor_data(struct gas_data *data);
-void ble_update_temp_hum(struct sensor_value *temp, struct sensor_value *hum);
-void ble_update_sound(void);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Copies the notification transmit counters.
+ */
+void ble_manager_get_tx_stats(struct ble_tx_stats *stats);
+
+#endif
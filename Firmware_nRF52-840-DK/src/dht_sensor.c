@@ -2,25 +2,30 @@
 #include <device.h>
 #include <drivers/sensor.h>
 #include "dht_sensor.h"
+#include "histo.h"
+
+/* Alias defined in app.overlay */
+#define DHT11_NODE DT_ALIAS(dht11)
 
 // Get the device binding from the Device Tree
-static const struct device *dht_dev;
+static const struct device *dht_dev = DEVICE_DT_GET(DHT11_NODE);
 
 int dht_init(void) {
-    dht_dev = DEVICE_DT_GET(DT_NODELABEL(dht11));
-
     if (!device_is_ready(dht_dev)) {
-        return -1;
+        return -ENODEV;
     }
     return 0;
 }
 
 int dht_read_data(struct sensor_value *temp, struct sensor_value *hum) {
+    uint32_t start = histo_start();
     int rc = sensor_sample_fetch(dht_dev);
+
+    histo_since(HISTO_FETCH_DHT, start);
     if (rc != 0) return rc;
 
     sensor_channel_get(dht_dev, SENSOR_CHAN_AMBIENT_TEMP, temp);
     sensor_channel_get(dht_dev, SENSOR_CHAN_HUMIDITY, hum);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,287 @@
+/* diag.c - Thread CPU and stack usage, queue depths, and the diag shell
+ * command. The thread figures come from CONFIG_THREAD_RUNTIME_STATS and
+ * the painted stacks, like the thread analyzer, but are returned instead
+ * of logged so the shell and the GATT characteristic can share them.
+ * The characteristic is served from a copy the system work queue
+ * refreshes, so a read on the BT RX thread neither waits for the shell
+ * nor scans the stacks itself.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <init.h>
+#include <sys/byteorder.h>
+#include <string.h>
+#ifdef CONFIG_SHELL
+#include <shell/shell.h>
+#endif
+
+#include "diag.h"
+#include "sample_ring.h"
+#include "sample_store.h"
+#include "sound_sensor.h"
+#include "ble_manager.h"
+#include "energy.h"
+#include "adaptive.h"
+
+#define MAX_THREADS CONFIG_APP_DIAG_MAX_THREADS
+#define REFRESH_MS  (CONFIG_APP_DIAG_REFRESH_SEC * MSEC_PER_SEC)
+
+#ifdef CONFIG_APP_ADAPTIVE
+BUILD_ASSERT(DIAG_ADAPTIVE_CHANNELS == ADAPTIVE_CHANNEL_COUNT,
+             "diag.h lists every adaptive channel");
+#endif
+
+/* Shared by the refresh work and the shell under the lock */
+static struct diag_thread threads[MAX_THREADS];
+static K_MUTEX_DEFINE(threads_lock);
+
+/* Payload last encoded by refresh_handler(); scratch is its own */
+static uint8_t scratch[DIAG_LEN(MAX_THREADS)];
+static uint8_t latest[DIAG_LEN(MAX_THREADS)];
+static size_t latest_len;
+static struct k_spinlock latest_lock;
+
+static void refresh_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(refresh_work, refresh_handler);
+
+struct collect {
+    struct diag_thread *out;
+    size_t max;
+    size_t count;
+    uint64_t total;
+};
+
+static void collect_thread(const struct k_thread *cthread, void *user_data)
+{
+    struct k_thread *thread = (struct k_thread *)cthread;
+    struct collect *c = user_data;
+    k_thread_runtime_stats_t rt;
+    size_t unused = 0;
+
+    if (c->count >= c->max) {
+        return;
+    }
+
+    struct diag_thread *t = &c->out[c->count++];
+    const char *name = k_thread_name_get(thread);
+
+    t->name = name && name[0] ? name : "?";
+    t->stack_size = thread->stack_info.size;
+    t->stack_used = k_thread_stack_space_get(thread, &unused) ? 0 : t->stack_size - unused;
+    t->cycles = k_thread_runtime_stats_get(thread, &rt) ? 0 : rt.execution_cycles;
+    c->total += t->cycles;
+}
+
+size_t diag_threads(struct diag_thread *out, size_t max, uint64_t *total)
+{
+    struct collect c = { .out = out, .max = max };
+
+    /* Stack scans take a while; threads do not come and go after boot */
+    k_thread_foreach_unlocked(collect_thread, &c);
+    if (total) {
+        *total = c.total;
+    }
+    return c.count;
+}
+
+void diag_queues(struct diag_queues *q)
+{
+    struct sample_ring_stats ring;
+
+    memset(q, 0, sizeof(*q));
+
+    sample_ring_get_stats(&ring);
+    q->ring_published = ring.published;
+    q->ring_max_lag = ring.max_lag;
+    q->ring_lost = ring.lost;
+
+#ifndef CONFIG_APP_SYNTH_SENSORS
+    struct sound_stats snd;
+
+    sound_sensor_get_stats(&snd);
+    q->sound_coalesced = snd.coalesced;
+    q->sound_dropped = snd.dropped;
+#endif
+
+#ifndef CONFIG_APP_MESH_SENSOR
+    struct ble_tx_stats tx;
+
+    ble_manager_get_tx_stats(&tx);
+    q->tx_sent = tx.sent;
+    q->tx_coalesced = tx.coalesced;
+    q->tx_dropped = tx.dropped;
+#endif
+
+#ifdef CONFIG_SAMPLE_STORE
+    uint32_t first, next;
+
+    sample_store_range(&first, &next);
+    q->log_records = next - first;
+#endif
+}
+
+/* 0.1 % of the total */
+static uint16_t permille(uint64_t part, uint64_t total)
+{
+    return total ? (uint16_t)(part * 1000 / total) : 0;
+}
+
+size_t diag_encode(uint8_t *buf, size_t size)
+{
+    struct diag_queues q;
+    uint64_t total;
+    size_t count, len;
+
+    if (size < DIAG_HDR_LEN) {
+        return 0;
+    }
+
+    k_mutex_lock(&threads_lock, K_FOREVER);
+    count = diag_threads(threads, MIN(MAX_THREADS, (size - DIAG_HDR_LEN) / DIAG_THREAD_LEN),
+                         &total);
+    diag_queues(&q);
+
+    buf[0] = DIAG_VERSION;
+    buf[1] = (uint8_t)count;
+    sys_put_le32(k_uptime_get_32(), &buf[2]);
+    sys_put_le32(q.ring_published, &buf[6]);
+    sys_put_le16((uint16_t)MIN(q.ring_max_lag, UINT16_MAX), &buf[10]);
+    sys_put_le32(q.ring_lost, &buf[12]);
+    sys_put_le32(q.sound_coalesced, &buf[16]);
+    sys_put_le32(q.sound_dropped, &buf[20]);
+    sys_put_le32(q.tx_sent, &buf[24]);
+    sys_put_le32(q.tx_coalesced, &buf[28]);
+    sys_put_le32(q.tx_dropped, &buf[32]);
+    sys_put_le32(q.log_records, &buf[36]);
+    memset(&buf[40], 0, DIAG_HDR_LEN - 40);
+#ifdef CONFIG_APP_ENERGY
+    struct energy_stats e;
+
+    energy_get(&e);
+    sys_put_le32(e.avg_ua, &buf[40]);
+    sys_put_le32(e.per_sample_nc, &buf[44]);
+    sys_put_le16(permille(e.cpu_us, e.uptime_us), &buf[48]);
+    sys_put_le16(permille(e.radio_us, e.uptime_us), &buf[50]);
+#endif
+#ifdef CONFIG_APP_ADAPTIVE
+    /* The low-power build has no console, so the rates are only seen here */
+    for (int ch = 0; ch < ADAPTIVE_CHANNEL_COUNT; ch++) {
+        struct adaptive_info info;
+
+        if (adaptive_get(ch, &info) == 0) {
+            sys_put_le32(info.want_ms, &buf[52 + ch * 8]);
+            sys_put_le32(info.period_ms, &buf[56 + ch * 8]);
+        }
+    }
+#endif
+
+    len = DIAG_HDR_LEN;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *e = &buf[len];
+
+        memset(e, 0, DIAG_NAME_LEN);
+        strncpy((char *)e, threads[i].name, DIAG_NAME_LEN);
+        sys_put_le16((uint16_t)MIN(threads[i].stack_size, UINT16_MAX), &e[8]);
+        sys_put_le16((uint16_t)MIN(threads[i].stack_used, UINT16_MAX), &e[10]);
+        sys_put_le16(permille(threads[i].cycles, total), &e[12]);
+        len += DIAG_THREAD_LEN;
+    }
+    k_mutex_unlock(&threads_lock);
+    return len;
+}
+
+static void refresh_handler(struct k_work *work)
+{
+    size_t len = diag_encode(scratch, sizeof(scratch));
+    k_spinlock_key_t key = k_spin_lock(&latest_lock);
+
+    memcpy(latest, scratch, len);
+    latest_len = len;
+    k_spin_unlock(&latest_lock, key);
+
+    k_work_schedule(&refresh_work, K_MSEC(REFRESH_MS));
+}
+
+size_t diag_latest(uint8_t *buf, size_t size)
+{
+    k_spinlock_key_t key = k_spin_lock(&latest_lock);
+    size_t len = latest_len <= size ? latest_len : 0;
+
+    memcpy(buf, latest, len);
+    k_spin_unlock(&latest_lock, key);
+    return len;
+}
+
+static int diag_refresh_init(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+
+    k_work_schedule(&refresh_work, K_NO_WAIT);
+    return 0;
+}
+
+SYS_INIT(diag_refresh_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+#ifdef CONFIG_SHELL
+static int cmd_diag_threads(const struct shell *sh, size_t argc, char **argv)
+{
+    uint64_t total;
+    size_t count;
+
+    k_mutex_lock(&threads_lock, K_FOREVER);
+    count = diag_threads(threads, MAX_THREADS, &total);
+
+    shell_print(sh, "%-20s %11s %7s", "thread", "stack", "cpu");
+    for (size_t i = 0; i < count; i++) {
+        uint16_t pm = permille(threads[i].cycles, total);
+
+        shell_print(sh, "%-20s %5u/%-5u %5u.%u%%", threads[i].name,
+                    threads[i].stack_used, threads[i].stack_size, pm / 10, pm % 10);
+    }
+    k_mutex_unlock(&threads_lock);
+    return 0;
+}
+
+static int cmd_diag_queues(const struct shell *sh, size_t argc, char **argv)
+{
+    struct diag_queues q;
+
+    diag_queues(&q);
+    shell_print(sh, "ring: %u published, slowest consumer %u behind, %u lost",
+                q.ring_published, q.ring_max_lag, q.ring_lost);
+    shell_print(sh, "sound edges: %u coalesced, %u dropped", q.sound_coalesced, q.sound_dropped);
+    shell_print(sh, "notifications: %u sent, %u coalesced, %u dropped",
+                q.tx_sent, q.tx_coalesced, q.tx_dropped);
+    shell_print(sh, "flash log: %u records", q.log_records);
+    return 0;
+}
+
+#ifdef CONFIG_APP_ENERGY
+static int cmd_diag_energy(const struct shell *sh, size_t argc, char **argv)
+{
+    struct energy_stats e;
+    uint16_t cpu, radio, sensor;
+
+    energy_get(&e);
+    cpu = permille(e.cpu_us, e.uptime_us);
+    radio = permille(e.radio_us, e.uptime_us);
+    sensor = permille(e.sensor_us, e.uptime_us);
+    shell_print(sh, "active: cpu %u.%u%%, radio %u.%u%%, gas sensor %u.%u%%",
+                cpu / 10, cpu % 10, radio / 10, radio % 10, sensor / 10, sensor % 10);
+    shell_print(sh, "charge: %u mC total, %u uA average, %u nC per record (%u records)",
+                (uint32_t)(e.charge_uc / 1000), e.avg_ua, e.per_sample_nc, e.samples);
+    return 0;
+}
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(diag_cmds,
+    SHELL_CMD(threads, NULL, "Stack high-water mark and CPU share per thread", cmd_diag_threads),
+    SHELL_CMD(queues, NULL, "Sample ring, sound and notification depths", cmd_diag_queues),
+    SHELL_COND_CMD(CONFIG_APP_ENERGY, energy, NULL, "Active times and charge estimate",
+                   cmd_diag_energy),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(diag, &diag_cmds, "Runtime diagnostics", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,92 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+/* Diagnostics payload, little endian:
+ *  0  u8   version (DIAG_VERSION)
+ *  1  u8   thread entries that follow the queue block
+ *  2  u32  uptime, ms
+ *  6  u32  sample ring records published
+ * 10  u16  records the slowest ring consumer is behind
+ * 12  u32  ring records lost, all consumers
+ * 16  u32  sound edges coalesced by the refractory window
+ * 20  u32  sound edges dropped on a full event ring
+ * 24  u32  notifications sent
+ * 28  u32  notification updates coalesced
+ * 32  u32  notification records dropped
+ * 36  u32  records in the flash log
+ * 40  u32  estimated average current, uA
+ * 44  u32  estimated charge per sample ring record, nC
+ * 48  u16  CPU active (threads but idle), 0.1 %
+ * 50  u16  radio active (modelled), 0.1 %
+ * 52  adaptive sampling, DIAG_ADAPTIVE_CHANNELS entries in enum
+ *     adaptive_channel order (co, no2, nh3, ch4, c2h5oh, temp, hum):
+ *      u32 period the channel asks for, ms (0 before its first reading)
+ *      u32 period its sensor task runs at, ms
+ * 108 thread entries, DIAG_THREAD_LEN bytes each:
+ *      char[8] name, NUL padded and truncated
+ *      u16 stack size, u16 stack bytes used (high-water mark)
+ *      u16 CPU share since boot, 0.1 %
+ * Counters of parts left out of the build read 0.
+ */
+#define DIAG_VERSION      3
+#define DIAG_ADAPTIVE_CHANNELS 7
+#define DIAG_HDR_LEN      (52 + DIAG_ADAPTIVE_CHANNELS * 8)
+#define DIAG_NAME_LEN     8
+#define DIAG_THREAD_LEN   (DIAG_NAME_LEN + 6)
+#define DIAG_LEN(threads) (DIAG_HDR_LEN + (threads) * DIAG_THREAD_LEN)
+
+/* One thread, from the kernel runtime statistics and stack painting (the
+ * figures the thread analyzer prints)
+ */
+struct diag_thread {
+    const char *name;
+    uint32_t stack_size;
+    uint32_t stack_used;
+    uint64_t cycles;     /* execution cycles since boot */
+};
+
+/* Queue and buffer depths of the application */
+struct diag_queues {
+    uint32_t ring_published;
+    uint32_t ring_max_lag;
+    uint32_t ring_lost;
+    uint32_t sound_coalesced;
+    uint32_t sound_dropped;
+    uint32_t tx_sent;
+    uint32_t tx_coalesced;
+    uint32_t tx_dropped;
+    uint32_t log_records;
+};
+
+/**
+ * @brief Collects every thread, up to max.
+ * @param total Sum of the execution cycles of all collected threads, idle
+ *        included, as the base for CPU shares. May be NULL.
+ * @return number of entries written to out.
+ */
+size_t diag_threads(struct diag_thread *out, size_t max, uint64_t *total);
+
+/**
+ * @brief Collects the queue and buffer depths.
+ */
+void diag_queues(struct diag_queues *q);
+
+/**
+ * @brief Encodes the diagnostics payload.
+ * @param size At least DIAG_LEN(CONFIG_APP_DIAG_MAX_THREADS) for all threads
+ * @return number of bytes written.
+ */
+size_t diag_encode(uint8_t *buf, size_t size);
+
+/**
+ * @brief Copies the payload the system work queue last encoded, every
+ *        CONFIG_APP_DIAG_REFRESH_SEC. Never blocks, for the GATT read.
+ * @param size At least DIAG_LEN(CONFIG_APP_DIAG_MAX_THREADS)
+ * @return number of bytes written, 0 before the first refresh.
+ */
+size_t diag_latest(uint8_t *buf, size_t size);
+
+#endif
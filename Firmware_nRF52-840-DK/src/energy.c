@@ -0,0 +1,143 @@
+/* energy.c - Charge estimate from CPU, radio and sensor on times
+ *
+ * Nothing here measures current. CPU time comes from the kernel runtime
+ * statistics (every thread but idle), radio time from a model of the
+ * advertising and connection events plus the bytes notified, sensor time
+ * from the supply switching. Each is multiplied by the Kconfig current of
+ * that part, on top of the System ON floor for the whole uptime.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <string.h>
+
+#include "energy.h"
+#include "sample_ring.h"
+
+#ifdef CONFIG_BT_MAX_CONN
+#define SLOTS (1 + CONFIG_BT_MAX_CONN)
+#else
+#define SLOTS 1
+#endif
+
+/* Radio model, 1M PHY: a connection event exchanging empty packets and a
+ * three-channel legacy advertising event, ramp-up included. advDelay adds
+ * 0..10 ms to every advertising interval.
+ */
+#define CONN_EVENT_US   600
+#define ADV_EVENT_US    1800
+#define ADV_DELAY_US    5000
+#define TX_US_PER_BYTE  8
+#define TX_HDR_LEN      7  /* L2CAP and ATT headers of a notification */
+
+struct radio_slot {
+    uint32_t interval_us;
+    uint64_t since_us;
+};
+
+static struct radio_slot slots[SLOTS];
+static uint64_t radio_closed_us;  /* slot time before the last change */
+static uint64_t tx_us;
+static bool sensor_on;
+static uint64_t sensor_since_us;
+static uint64_t sensor_closed_us;
+static struct k_spinlock lock;
+
+static uint64_t now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static uint64_t slot_us(int slot, uint64_t now)
+{
+    const struct radio_slot *s = &slots[slot];
+
+    if (!s->interval_us) {
+        return 0;
+    }
+    if (slot == ENERGY_SLOT_ADV) {
+        return (now - s->since_us) / (s->interval_us + ADV_DELAY_US) * ADV_EVENT_US;
+    }
+    return (now - s->since_us) / s->interval_us * CONN_EVENT_US;
+}
+
+void energy_radio_set(int slot, uint32_t interval_us)
+{
+    if (slot < 0 || slot >= SLOTS) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint64_t now = now_us();
+
+    radio_closed_us += slot_us(slot, now);
+    slots[slot].interval_us = interval_us;
+    slots[slot].since_us = now;
+    k_spin_unlock(&lock, key);
+}
+
+void energy_radio_tx(uint16_t len)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    tx_us += (len + TX_HDR_LEN) * TX_US_PER_BYTE;
+    k_spin_unlock(&lock, key);
+}
+
+void energy_sensor_power(bool on)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint64_t now = now_us();
+
+    if (sensor_on) {
+        sensor_closed_us += now - sensor_since_us;
+    }
+    sensor_on = on;
+    sensor_since_us = now;
+    k_spin_unlock(&lock, key);
+}
+
+static void add_thread_cycles(const struct k_thread *cthread, void *user_data)
+{
+    struct k_thread *thread = (struct k_thread *)cthread;
+    const char *name = k_thread_name_get(thread);
+    uint64_t *cycles = user_data;
+    k_thread_runtime_stats_t rt;
+
+    if (name && !strncmp(name, "idle", 4)) {
+        return;
+    }
+    if (!k_thread_runtime_stats_get(thread, &rt)) {
+        *cycles += rt.execution_cycles;
+    }
+}
+
+void energy_get(struct energy_stats *st)
+{
+    struct sample_ring_stats ring;
+    uint64_t cycles = 0;
+
+    k_thread_foreach_unlocked(add_thread_cycles, &cycles);
+    sample_ring_get_stats(&ring);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint64_t now = now_us();
+
+    st->uptime_us = now;
+    st->radio_us = radio_closed_us + tx_us;
+    for (int i = 0; i < SLOTS; i++) {
+        st->radio_us += slot_us(i, now);
+    }
+    st->sensor_us = sensor_closed_us + (sensor_on ? now - sensor_since_us : 0);
+    k_spin_unlock(&lock, key);
+
+    st->cpu_us = k_cyc_to_us_floor64(cycles);
+    st->charge_uc = (st->cpu_us * CONFIG_APP_ENERGY_CPU_UA +
+                     st->radio_us * CONFIG_APP_ENERGY_RADIO_UA +
+                     st->sensor_us * CONFIG_APP_ENERGY_SENSOR_UA +
+                     st->uptime_us * CONFIG_APP_ENERGY_SLEEP_UA) / 1000000;
+    st->avg_ua = st->uptime_us ? (uint32_t)(st->charge_uc * 1000000 / st->uptime_us) : 0;
+    st->samples = ring.published;
+    st->per_sample_nc = ring.published ?
+                        (uint32_t)MIN(st->charge_uc * 1000 / ring.published, UINT32_MAX) : 0;
+}
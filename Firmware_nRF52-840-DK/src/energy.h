@@ -0,0 +1,69 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/* Radio activity slots: connectable advertising, then one per connection
+ * index
+ */
+#define ENERGY_SLOT_ADV     0
+#define ENERGY_SLOT_CONN(n) (1 + (n))
+
+/* Charge estimate since boot. Times are what the model charges for: CPU
+ * time of every thread but idle, radio on time derived from event counts
+ * and bytes sent, and gas sensor powered time.
+ */
+struct energy_stats {
+    uint64_t uptime_us;
+    uint64_t cpu_us;
+    uint64_t radio_us;
+    uint64_t sensor_us;
+    uint64_t charge_uc;      /* total, uC */
+    uint32_t avg_ua;         /* charge over uptime */
+    uint32_t samples;        /* records published to the sample ring */
+    uint32_t per_sample_nc;  /* charge per record, nC */
+};
+
+#ifdef CONFIG_APP_ENERGY
+
+/**
+ * @brief Sets the event interval of a radio slot from now on.
+ * @param interval_us Time between events, 0 when the slot is idle. For a
+ *        connection with peripheral latency, the interval times
+ *        (1 + latency).
+ */
+void energy_radio_set(int slot, uint32_t interval_us);
+
+/**
+ * @brief Adds the air time of a notification of len bytes.
+ */
+void energy_radio_tx(uint16_t len);
+
+/**
+ * @brief Gas sensor supply switched on or off.
+ */
+void energy_sensor_power(bool on);
+
+/**
+ * @brief Current estimate.
+ */
+void energy_get(struct energy_stats *st);
+
+#else
+
+static inline void energy_radio_set(int slot, uint32_t interval_us)
+{
+}
+
+static inline void energy_radio_tx(uint16_t len)
+{
+}
+
+static inline void energy_sensor_power(bool on)
+{
+}
+
+#endif /* CONFIG_APP_ENERGY */
+
+#endif
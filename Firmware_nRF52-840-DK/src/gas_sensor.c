@@ -1,83 +1,159 @@
-/* gas_sensor.c - Read multichannel gas sensor over I2C and provide functions
- * to return the results as floats or bytes.
+/* gas_sensor.c - Read the multichannel gas sensor through its sensor driver
+ * and publish the readings to the sample ring.
  */
 
 #include <zephyr.h>
 #include <device.h>
-#include <drivers/i2c.h>
+#include <drivers/sensor.h>
 #include <logging/log.h>
-#include <sys/printk.h>
-#include <string.h>
+#include <pm/device.h>
+#include <seeed_mgs.h>
 
 #include "gas_sensor.h"
+#include "sample_ring.h"
+#include "histo.h"
+#include "energy.h"
 
 LOG_MODULE_REGISTER(gas_sensor, LOG_LEVEL_INF);
 
-#define GAS_SENSOR_ADDR 0x04
-/* Sensor gas code (from your original file) */
-LOG_MODULE_REGISTER(gas_sensor, LOG_LEVEL_INF);
+#define GAS_NODE DT_NODELABEL(gas_sensor)
+
+static const enum sensor_channel gas_chans[GAS_CHANNEL_COUNT] = {
+	[GAS_CH_CO]   = SENSOR_CHAN_SEEED_MGS_CO,
+	[GAS_CH_NO2]  = SENSOR_CHAN_SEEED_MGS_NO2,
+	[GAS_CH_NH3]  = SENSOR_CHAN_SEEED_MGS_NH3,
+	[GAS_CH_CH4]  = SENSOR_CHAN_SEEED_MGS_CH4,
+	[GAS_CH_ETOH] = SENSOR_CHAN_SEEED_MGS_C2H5OH,
+};
 
-#define I2C_NODE DT_NODELABEL(i2c0)
-#define GAS_SENSOR_ADDR 0x04
+int gas_sensor_init(const struct device **dev)
+{
+	*dev = DEVICE_DT_GET(GAS_NODE);
+	if (!device_is_ready(*dev)) {
+		return -ENODEV;
+	}
+	energy_sensor_power(true);
+	return 0;
+}
 
-/* Register map from Seeed/Arduino source */
-#define GAS_CO_REG 	0x02
-#define GAS_NO2_REG 	0x04
-#define GAS_NH3_REG 	0x06
-#define GAS_CH4_REG 	0x08
-#define GAS_C2H5OH_REG 	0x0A
+static float gas_channel(const struct device *dev, enum gas_channel ch, uint8_t *valid)
+{
+	struct sensor_value val;
 
-#define GAS_SCALE 100.0f  /* raw / scale => ppm */
+	if (sensor_channel_get(dev, gas_chans[ch], &val)) {
+		return 0.0f;
+	}
+	*valid |= BIT(ch);
+	return (float)sensor_value_to_double(&val);
+}
 
-static float read_gas(const struct device *i2c_dev, uint8_t reg)
+int gas_sensor_read_all(const struct device *dev, struct gas_data *data)
 {
-	uint8_t buf[2];
-	int ret = i2c_write_read(i2c_dev, GAS_SENSOR_ADDR, &reg, 1, buf, sizeof(buf));
+	uint32_t start = histo_start();
+	int ret = sensor_sample_fetch(dev);
+
+	histo_since(HISTO_FETCH_GAS, start);
+
+	data->valid = 0;
 	if (ret) {
-		printk("I2C read failed reg 0x%02x (err %d)\n", reg, ret);
-		return -1.0f;
+		data->co = data->no2 = data->nh3 = data->ch4 = data->etoh = 0.0f;
+		return ret;
+	}
+
+	data->co   = gas_channel(dev, GAS_CH_CO, &data->valid);
+	data->no2  = gas_channel(dev, GAS_CH_NO2, &data->valid);
+	data->nh3  = gas_channel(dev, GAS_CH_NH3, &data->valid);
+	data->ch4  = gas_channel(dev, GAS_CH_CH4, &data->valid);
+	data->etoh = gas_channel(dev, GAS_CH_ETOH, &data->valid);
+	return 0;
+}
+
+void read_all_gases(const struct device *dev)
+{
+	struct sample smp = { .kind = SAMPLE_GAS };
+
+	if (gas_sensor_read_all(dev, &smp.gas)) {
+		return;
+	}
+	sample_ring_publish(&smp);
+}
+
+#ifdef CONFIG_APP_POWER
+/* A read this close to the end of the warm-up still counts, so timer
+ * rounding does not cost a whole period
+ */
+#define WARM_SLACK_MS (CONFIG_APP_POWER_GAS_WARMUP_MS / 10)
+
+/* All of the state below lives on the system work queue: the gas task,
+ * the wake-up work and the adaptive sampler all run there.
+ */
+static const struct device *gated_dev;
+static bool always_on;  /* no power line to switch */
+static bool powered = true;
+static int64_t warm_at_ms;  /* supply on long enough from then on */
+
+static void gas_power_on(void)
+{
+	int err = pm_device_state_set(gated_dev, PM_DEVICE_STATE_ACTIVE);
+
+	if (err) {
+		LOG_WRN("Gas sensor power on failed (err %d)", err);
+		return;
 	}
-	uint16_t raw = ((uint16_t)buf[0] << 8) | buf[1];
-	return (float)raw / GAS_SCALE;
+	powered = true;
+	warm_at_ms = k_uptime_get() + CONFIG_APP_POWER_GAS_WARMUP_MS;
+	energy_sensor_power(true);
+}
+
+static void gas_wake_handler(struct k_work *work)
+{
+	gas_power_on();
+}
+
+static K_WORK_DELAYABLE_DEFINE(gas_wake_work, gas_wake_handler);
+
+bool gas_sensor_warm(void)
+{
+	return powered && k_uptime_get() + WARM_SLACK_MS >= warm_at_ms;
 }
 
-/* Helper function to copy a float into our byte buffer */
-static void float_to_bytes(float f, uint8_t *buf)
+uint32_t gas_sensor_set_period(uint32_t period_ms)
 {
-	/* Assumes little-endian, which is correct for nRF52 */
-	memcpy(buf, &f, sizeof(f));
+	/* The wake-up planned for the old period would come too late for
+	 * a shorter one; power up now and let the sensor warm
+	 */
+	if (!powered &&
+	    period_ms < CONFIG_APP_POWER_GAS_WARMUP_MS + CONFIG_APP_POWER_GAS_MIN_OFF_MS) {
+		k_work_cancel_delayable(&gas_wake_work);
+		gas_power_on();
+	}
+	if (!powered) {
+		return period_ms;
+	}
+
+	int64_t left = warm_at_ms - k_uptime_get();
+
+	return left > 0 ? MAX(period_ms, (uint32_t)left) : period_ms;
 }
 
-static void read_all_gases(const struct device *i2c_dev)
+void gas_sensor_idle(const struct device *dev, uint32_t period_ms)
 {
-	float co   = read_gas(i2c_dev, GAS_CO_REG);
-	float no2  = read_gas(i2c_dev, GAS_NO2_REG);
-	float nh3  = read_gas(i2c_dev, GAS_NH3_REG);
-	float ch4  = read_gas(i2c_dev, GAS_CH4_REG);
-	float etoh = read_gas(i2c_dev, GAS_C2H5OH_REG);
-
-	/* Use integer print to avoid float formatting (same as your code) */
-	uint16_t co_i   = (uint16_t)(co   * 100);
-	uint16_t no2_i  = (uint16_t)(no2  * 100);
-	uint16_t nh3_i  = (uint16_t)(nh3  * 100);
-	uint16_t ch4_i  = (uint16_t)(ch4  * 100);
-	uint16_t etoh_i = (uint16_t)(etoh * 100);
-
-	printk("CO:%u.%02u NO2:%u.%02u NH3:%u.%02u CH4:%u.%02u C2H5OH:%u.%02u ppm\n",
-		   co_i/100,   co_i%100,
-		   no2_i/100,  no2_i%100,
-		   nh3_i/100,  nh3_i%100,
-		   ch4_i/100,  ch4_i%100,
-		   etoh_i/100, etoh_i%100);
-
-	/* --- NEW: Prepare a local buffer and notify via bluetooth_service --- */
-	uint8_t buf[20];
-	float_to_bytes(co,   &buf[0]);
-	float_to_bytes(no2,  &buf[4]);
-	float_to_bytes(nh3,  &buf[8]);
-	float_to_bytes(ch4,  &buf[12]);
-	float_to_bytes(etoh, &buf[16]);
-
-	/* Notify via new bluetooth module */
-	bluetooth_gas_update_and_notify(buf, sizeof(buf));
+	int err;
+
+	if (always_on ||
+	    period_ms < CONFIG_APP_POWER_GAS_WARMUP_MS + CONFIG_APP_POWER_GAS_MIN_OFF_MS) {
+		return;
+	}
+
+	err = pm_device_state_set(dev, PM_DEVICE_STATE_SUSPENDED);
+	if (err) {
+		LOG_INF("Gas sensor stays powered, no power-gpios (err %d)", err);
+		always_on = true;
+		return;
+	}
+	energy_sensor_power(false);
+	powered = false;
+	gated_dev = dev;
+	k_work_schedule(&gas_wake_work, K_MSEC(period_ms - CONFIG_APP_POWER_GAS_WARMUP_MS));
 }
+#endif /* CONFIG_APP_POWER */
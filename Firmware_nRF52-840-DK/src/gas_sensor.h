@@ -2,6 +2,19 @@
 #define GAS_SENSOR_H
 
 #include <device.h>
+#include <sys/util.h>
+
+/* Channels exposed by the Seeed multichannel gas sensor, in register order */
+enum gas_channel {
+    GAS_CH_CO,
+    GAS_CH_NO2,
+    GAS_CH_NH3,
+    GAS_CH_CH4,
+    GAS_CH_ETOH,
+    GAS_CHANNEL_COUNT
+};
+
+#define GAS_VALID_ALL (BIT_MASK(GAS_CHANNEL_COUNT))
 
 /* Struct to hold all gas readings in one place */
 struct gas_data {
@@ -10,9 +23,54 @@ struct gas_data {
     float nh3;
     float ch4;
     float etoh;
+    uint8_t valid;  /* BIT(enum gas_channel) set for every channel read correctly */
 };
 
-int gas_sensor_init(const struct device **i2c_dev);
-int gas_sensor_read_all(const struct device *i2c_dev, struct gas_data *data);
+/**
+ * @brief Gets the gas sensor device bound to the gas_sensor node.
+ * @param dev Where to store the sensor device
+ * @return 0 on success, negative error code otherwise.
+ */
+int gas_sensor_init(const struct device **dev);
+
+/**
+ * @brief Fetches the five gas channels (one I2C transfer in the driver).
+ *
+ * Channels the sensor reports as not ready are left at 0 and cleared in
+ * data->valid; a bus error clears every bit.
+ * @return 0 if the fetch completed, negative error code otherwise.
+ */
+int gas_sensor_read_all(const struct device *dev, struct gas_data *data);
+
+/**
+ * @brief Reads all gases and publishes them to the sample ring.
+ */
+void read_all_gases(const struct device *dev);
+
+/**
+ * @brief Switches the sensor supply off after a read and back on
+ *        CONFIG_APP_POWER_GAS_WARMUP_MS before the next one, when the
+ *        period leaves at least CONFIG_APP_POWER_GAS_MIN_OFF_MS off. Does
+ *        nothing for shorter periods or without power-gpios.
+ * @param period_ms Time until the next read
+ */
+void gas_sensor_idle(const struct device *dev, uint32_t period_ms);
+
+/**
+ * @brief Applies a new gas task period to the supply gating. A period too
+ *        short to switch off in that finds the supply off powers the
+ *        sensor up at once rather than at the wake-up planned for the old
+ *        period. Call from the system work queue before the new period
+ *        takes effect.
+ * @return The period to run at: period_ms, or the warm-up time still
+ *         left when that is longer.
+ */
+uint32_t gas_sensor_set_period(uint32_t period_ms);
+
+/**
+ * @brief Whether the supply has been on for the warm-up time. Reads
+ *        taken before then would be invalid and should be skipped.
+ */
+bool gas_sensor_warm(void);
 
-#endif
\ No newline at end of file
+#endif
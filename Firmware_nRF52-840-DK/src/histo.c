@@ -0,0 +1,108 @@
+/* histo.c - Period, bus and latency histograms, and the histo shell
+ * command. Recording is inline in histo.h (a count of leading zeros, an
+ * increment and a compare) so it stays on in production builds; this file
+ * only names, clears and exports the buckets.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <sys/byteorder.h>
+#include <string.h>
+#ifdef CONFIG_SHELL
+#include <shell/shell.h>
+#endif
+
+#include "histo.h"
+
+struct histo histo_table[HISTO_COUNT];
+
+static const char *const names[HISTO_COUNT] = {
+    [HISTO_PERIOD_GAS] = "period_gas",
+    [HISTO_PERIOD_ENV] = "period_env",
+    [HISTO_PERIOD_SOUND] = "period_sound",
+    [HISTO_FETCH_GAS] = "fetch_gas",
+    [HISTO_FETCH_DHT] = "fetch_dht",
+    [HISTO_NOTIFY] = "notify",
+};
+
+const char *histo_name(enum histo_id id)
+{
+    return id < HISTO_COUNT ? names[id] : "?";
+}
+
+void histo_reset(void)
+{
+    memset(histo_table, 0, sizeof(histo_table));
+}
+
+size_t histo_encode(uint8_t *buf, size_t size)
+{
+    if (size < HISTO_LEN) {
+        return 0;
+    }
+
+    buf[0] = HISTO_VERSION;
+    buf[1] = HISTO_COUNT;
+    buf[2] = HISTO_BUCKETS;
+    sys_put_le32(sys_clock_hw_cycles_per_sec(), &buf[3]);
+
+    for (int i = 0; i < HISTO_COUNT; i++) {
+        const struct histo *h = &histo_table[i];
+        uint8_t *e = &buf[HISTO_HDR_LEN + i * HISTO_ENTRY_LEN];
+
+        sys_put_le32(h->max, &e[0]);
+        for (int b = 0; b < HISTO_BUCKETS; b++) {
+            sys_put_le16((uint16_t)MIN(h->count[b], UINT16_MAX), &e[4 + b * 2]);
+        }
+    }
+    return HISTO_LEN;
+}
+
+#ifdef CONFIG_SHELL
+/* Upper bound of a bucket, us */
+static uint32_t bucket_limit_us(int b)
+{
+    return (uint32_t)k_cyc_to_us_ceil64((uint64_t)1 << b);
+}
+
+static int cmd_histo_show(const struct shell *sh, size_t argc, char **argv)
+{
+    for (int i = 0; i < HISTO_COUNT; i++) {
+        struct histo h = histo_table[i];
+        uint32_t total = 0;
+
+        for (int b = 0; b < HISTO_BUCKETS; b++) {
+            total += h.count[b];
+        }
+        shell_print(sh, "%s: %u, max %u us", names[i], total,
+                    (uint32_t)k_cyc_to_us_ceil64(h.max));
+
+        for (int b = 0; b < HISTO_BUCKETS; b++) {
+            if (!h.count[b]) {
+                continue;
+            }
+            if (b == HISTO_BUCKETS - 1) {
+                shell_print(sh, "  >= %9u us %10u", bucket_limit_us(b - 1), h.count[b]);
+            } else {
+                shell_print(sh, "  <  %9u us %10u", bucket_limit_us(b), h.count[b]);
+            }
+        }
+    }
+    return 0;
+}
+
+static int cmd_histo_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    histo_reset();
+    shell_print(sh, "histograms cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(histo_cmds,
+    SHELL_CMD(show, NULL, "Non-empty buckets of every histogram", cmd_histo_show),
+    SHELL_CMD(reset, NULL, "Clear every histogram", cmd_histo_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(histo, &histo_cmds, "Sampling period, bus and notify latency histograms", NULL);
+#endif /* CONFIG_SHELL */
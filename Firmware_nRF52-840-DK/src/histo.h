@@ -0,0 +1,116 @@
+#ifndef HISTO_H
+#define HISTO_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <kernel.h>
+#include <sys/util.h>
+
+/* Fixed log2 buckets over hardware cycle counts (k_cycle_get_32):
+ * bucket 0 holds 0, bucket b holds [2^(b-1), 2^b) cycles, the last one
+ * everything longer. 24 buckets reach 2 min at the 32768 Hz nRF52 counter
+ * and 65 ms at 64 MHz; the exact longest value is kept beside them.
+ */
+#define HISTO_BUCKETS 24
+
+/* Histograms payload, little endian:
+ *  0  u8   version (HISTO_VERSION)
+ *  1  u8   histograms that follow, in enum histo_id order
+ *  2  u8   buckets per histogram (HISTO_BUCKETS)
+ *  3  u32  cycle counter frequency, Hz
+ *  7  histograms, HISTO_ENTRY_LEN bytes each:
+ *      u32 longest value, cycles
+ *      u16 count per bucket, saturating
+ */
+#define HISTO_VERSION   2
+#define HISTO_HDR_LEN   7
+#define HISTO_ENTRY_LEN (4 + HISTO_BUCKETS * 2)
+#define HISTO_LEN       (HISTO_HDR_LEN + HISTO_COUNT * HISTO_ENTRY_LEN)
+
+enum histo_id {
+    HISTO_PERIOD_GAS,    /* |actual - nominal| gas sampling period */
+    HISTO_PERIOD_ENV,    /* |actual - nominal| temperature/humidity period */
+    HISTO_PERIOD_SOUND,  /* |actual - nominal| sound window period */
+    HISTO_FETCH_GAS,     /* sensor_sample_fetch() of the gas sensor, one I2C transfer */
+    HISTO_FETCH_DHT,     /* sensor_sample_fetch() of the DHT11 */
+    HISTO_NOTIFY,        /* newest reading of a frame to its sent callback */
+    HISTO_COUNT
+};
+
+/* One writer context per histogram; a reset racing a record loses at
+ * most that record
+ */
+struct histo {
+    uint32_t count[HISTO_BUCKETS];
+    uint32_t max;  /* cycles */
+};
+
+#ifdef CONFIG_APP_HISTO
+
+extern struct histo histo_table[HISTO_COUNT];
+
+#define HISTO(id) (&histo_table[(id)])
+
+static inline void histo_add(struct histo *h, uint32_t cyc)
+{
+    uint32_t b = cyc ? 32 - __builtin_clz(cyc) : 0;
+
+    h->count[MIN(b, HISTO_BUCKETS - 1)]++;
+    if (cyc > h->max) {
+        h->max = cyc;
+    }
+}
+
+/**
+ * @brief Start of a measured interval, for histo_since().
+ */
+static inline uint32_t histo_start(void)
+{
+    return k_cycle_get_32();
+}
+
+/**
+ * @brief Records the cycles elapsed since start.
+ */
+static inline void histo_since(enum histo_id id, uint32_t start)
+{
+    histo_add(HISTO(id), k_cycle_get_32() - start);
+}
+
+#else
+
+#define HISTO(id) NULL
+
+static inline void histo_add(struct histo *h, uint32_t cyc)
+{
+}
+
+static inline uint32_t histo_start(void)
+{
+    return 0;
+}
+
+static inline void histo_since(enum histo_id id, uint32_t start)
+{
+}
+
+#endif /* CONFIG_APP_HISTO */
+
+/**
+ * @brief Name of a histogram, as printed by the histo shell command.
+ */
+const char *histo_name(enum histo_id id);
+
+/**
+ * @brief Clears every histogram.
+ */
+void histo_reset(void);
+
+/**
+ * @brief Encodes the histograms payload.
+ * @param size At least HISTO_LEN
+ * @return number of bytes written, 0 if size is too small.
+ */
+size_t histo_encode(uint8_t *buf, size_t size);
+
+#endif
@@ -14,53 +14,123 @@
 #include <sys/printk.h>
 #include <sys/util.h>
 
-#include <string.h>
-#include <stdio.h>
-
 #include <drivers/sensor.h>
-
-//Include sensor gas
-#include <drivers/i2c.h>
 #include <logging/log.h>
 #include <zephyr.h>
 
 // Includes bluetooth and sensor files
-#include "bluetooth_service.h"
-#include "temp_humi.h"
+#include "ble_manager.h"
+#include "mesh_sensor.h"
+#include "dht_sensor.h"
 #include "gas_sensor.h"
+#include "sound_sensor.h"
+#include "sound_window.h"
+#include "sound_adc.h"
+#include "synth_sensors.h"
+#include "replay.h"
+#include "sample_ring.h"
+#include "sample_log.h"
+#include "sample_store.h"
+#include "sensor_sched.h"
+#include "histo.h"
+#include "adaptive.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
+
+#ifndef CONFIG_APP_SYNTH_SENSORS
+static const struct device *gas_dev;
+
+// Sound bottom half: runs on the system work queue once per batch of
+// edges and only folds them into the open window
+static void sound_detected(const uint32_t *stamps, size_t count)
+{
+	sound_window_add(stamps, count);
+}
+#endif
 
+#ifdef CONFIG_SOUND_ADC
+// Amplitude window from the ADC path, also on the system work queue
+static void sound_level_ready(const struct sound_level *level)
+{
+	struct sample smp = { .kind = SAMPLE_SOUND_LEVEL, .sound_level = *level };
 
-#define DEVICE_NAME CONFIG_BT_DEVICE_NAME
-#define DEVICE_NAME_LEN (sizeof(DEVICE_NAME) - 1)
+	sample_ring_publish(&smp);
+}
+#endif
 
-// --- Keep track of the current connection ---
-// Bluetooth connection and GATT handled in bluetooth_service.c 
+// One record per window instead of one notification per edge. The first
+// tick only reopens the window, so every published window starts on the
+// scheduler grid and spans exactly CONFIG_SOUND_WINDOW_MS; edges seen
+// during boot are dropped.
+static void sound_task_fn(struct sched_task *task)
+{
+	struct sample smp = { .kind = SAMPLE_SOUND };
 
-// Thread stack and thread object for DHT notify thread (file scope)
-K_THREAD_STACK_DEFINE(temp_humi_stack, 1024);
-static struct k_thread temp_humi_tid;
+	if (task->runs == 0) {
+		sound_window_init();
+		return;
+	}
 
-// --- Define Custom UUIDs for our Gas Sensor Service ---
-// Gas Sensor Service UUID: 47617353-656e-736f-7253-766300000000 (ASCII: "GasSensorSvc")
-#define BT_UUID_GAS_SENSOR_SERVICE_VAL \
-	BT_UUID_128_ENCODE(0x47617353, 0x656e, 0x736f, 0x7253, 0x766300000000)
-#define BT_UUID_GAS_SENSOR_SERVICE BT_UUID_DECLARE_128(BT_UUID_GAS_SENSOR_SERVICE_VAL)
+	sound_window_close(&smp.sound);
+	sample_ring_publish(&smp);
+}
 
-// Gas Readings Characteristic UUID: 47617352-6561-6469-6e67-73000000000 (ASCII: "GasReadings")
-#define BT_UUID_GAS_READINGS_CHAR_VAL \
-	BT_UUID_128_ENCODE(0x47617352, 0x6561, 0x6469, 0x6e67, 0x73000000000)
-#define BT_UUID_GAS_READINGS_CHAR BT_UUID_DECLARE_128(BT_UUID_GAS_READINGS_CHAR_VAL)
+#ifdef CONFIG_APP_SYNTH_SENSORS
+static void gas_task_fn(struct sched_task *task)
+{
+	struct sample smp = { .kind = SAMPLE_GAS };
 
-/*
-// Simple helper used by temp_humi module to forward notifications.
-int my_sensor_notify_string(const char *s)
+	synth_read_gas(&smp.gas);
+	sample_ring_publish(&smp);
+}
+
+static void env_task_fn(struct sched_task *task)
+{
+	struct sample smp = { .kind = SAMPLE_ENV };
+
+	synth_read_env(&smp.env.temp_c, &smp.env.hum_pct);
+	sample_ring_publish(&smp);
+}
+#else
+static void gas_task_fn(struct sched_task *task)
 {
-	if (!s) return -EINVAL;
-	printk("temp_humi: %s\n", s);
-	// For now, we simply log the string. If you want this over BLE, * implement a separate characteristic and use bt_gatt_notify here.
-	return 0;
+#ifdef CONFIG_APP_POWER
+	// Powered up early by an adaptive speed-up, still warming
+	if (!gas_sensor_warm()) {
+		return;
+	}
+#endif
+	read_all_gases(gas_dev);
+#ifdef CONFIG_APP_POWER
+	gas_sensor_idle(gas_dev, task->period_ms);
+#endif
 }
-*/
+
+static void env_task_fn(struct sched_task *task)
+{
+	struct sensor_value temp, hum;
+
+	if (dht_read_data(&temp, &hum) == 0) {
+		struct sample smp = {
+			.kind = SAMPLE_ENV,
+			.env.temp_c = (float)sensor_value_to_double(&temp),
+			.env.hum_pct = (float)sensor_value_to_double(&hum),
+		};
+
+		sample_ring_publish(&smp);
+	} else {
+		LOG_WRN("DHT11 fetch failed");
+	}
+}
+#endif /* CONFIG_APP_SYNTH_SENSORS */
+
+// Both sensors share the scheduler grid, so same-period tasks land in one tick
+static struct sched_task gas_task = SCHED_TASK_INITIALIZER("gas", gas_task_fn,
+		CONFIG_APP_GAS_PERIOD_MS, 0);
+static struct sched_task env_task = SCHED_TASK_INITIALIZER("env", env_task_fn,
+		CONFIG_APP_ENV_PERIOD_MS, 0);
+static struct sched_task sound_task = SCHED_TASK_INITIALIZER("sound", sound_task_fn,
+		CONFIG_SOUND_WINDOW_MS, 0);
 
 
 void main(void)
@@ -68,35 +138,88 @@ void main(void)
 	int err;
 	printk("Starting Multichannel Gas Sensor (GATT Server mode)\n");
 
-	// --- NEW: Initialize Bluetooth (through bluetooth_service) ---
-	err = bluetooth_service_init();
+#ifdef CONFIG_APP_MESH_SENSOR
+	err = mesh_sensor_init();
+#else
+	err = ble_manager_init();
+#endif
 	if (err) {
-		printk("Bluetooth init failed (err %d)\n", err);
-		return;
+		// Keep sampling into the log and console; host runs without
+		// --bt-dev land here too
+		printk("Bluetooth init failed (err %d), continuing without it\n", err);
 	}
-	// bt_ready() will be called when BLE stack is up
 
+#ifndef CONFIG_APP_SYNTH_SENSORS
+	// --- Gas sensor (seeed,multichannel-gas driver) ---
+	if (gas_sensor_init(&gas_dev)) {
+		printk("Gas sensor not ready\n");
+		return;
+	}
 
-	// --- Your existing I2C init code ---
-	const struct device *i2c_dev = DEVICE_DT_GET(I2C_NODE);
-	if (!device_is_ready(i2c_dev)) {
-		printk("I2C device not ready\n");
+	if (dht_init()) {
+		printk("DHT11 device not ready\n");
 		return;
 	}
+#endif
 
-	k_sleep(K_SECONDS(1));   // allow sensor MCU to boot
+	sample_log_init();
+
+#ifdef CONFIG_SAMPLE_STORE
+	err = sample_store_init();
+	if (err) {
+		printk("Sample store init failed (err %d)\n", err);
+	}
+#endif
 
-	// Start DHT11 notify thread (spawns the temp_humi task)
-	(void)k_thread_create(&temp_humi_tid, temp_humi_stack,
-						  K_THREAD_STACK_SIZEOF(temp_humi_stack),
-						  (k_thread_entry_t)dht11_notify_thread, NULL, NULL, NULL,
-						  K_PRIO_COOP(8), 0, K_NO_WAIT);
-	
+	sound_window_init();
+#ifndef CONFIG_APP_SYNTH_SENSORS
+	err = sound_sensor_init(sound_detected);
+	if (err) {
+		printk("Sound sensor init failed (err %d)\n", err);
+	}
+#endif
 
-	while (1) {
-		read_all_gases(i2c_dev);
-		k_sleep(K_SECONDS(2));
+#ifdef CONFIG_SOUND_ADC
+	err = sound_adc_init(sound_level_ready);
+	if (err) {
+		printk("Sound ADC init failed (err %d)\n", err);
 	}
-}
+#endif
+
+	k_sleep(K_SECONDS(1));   // allow sensor MCU to boot
 
+#ifdef CONFIG_APP_REPLAY
+	// Recorded readings replace the emulators' own before the first tick
+	err = replay_start();
+	if (err) {
+		printk("Replay not started (err %d)\n", err);
+	}
+#endif
+
+	// Period deviation per sensor (histo shell command / characteristic)
+	gas_task.jitter = HISTO(HISTO_PERIOD_GAS);
+	env_task.jitter = HISTO(HISTO_PERIOD_ENV);
+	sound_task.jitter = HISTO(HISTO_PERIOD_SOUND);
+	sched_add(&gas_task);
+	sched_add(&env_task);
+	sched_add(&sound_task);
+#ifdef CONFIG_APP_ADAPTIVE
+	// Retunes the gas and env periods from their readings
+	adaptive_init(&gas_task, &env_task);
+#endif
+	sched_start();
+
+#ifdef CONFIG_APP_DIAG
+	// main exits here and drops out of the diag thread list, so report
+	// its high-water mark now to size CONFIG_MAIN_STACK_SIZE
+	size_t unused;
+
+	if (k_thread_stack_space_get(k_current_get(), &unused) == 0) {
+		printk("main stack: %u of %u bytes used\n",
+		       (unsigned int)(k_current_get()->stack_info.size - unused),
+		       (unsigned int)k_current_get()->stack_info.size);
+	}
+#endif
 
+	// Sampling continues on the system work queue, main's stack is done
+}
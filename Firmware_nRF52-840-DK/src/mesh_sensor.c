@@ -0,0 +1,599 @@
+/* mesh_sensor.c - Bluetooth Mesh Sensor Server and Sensor Setup Server
+ *
+ * Mesh build variant of the GATT service: the latest readings are kept as
+ * Mesh Device Property values and published in Sensor Status messages,
+ * periodically at the model publication period and on deltas, following
+ * the Sensor Cadence state of each property. Relaying is left to the
+ * Configuration Server, so a house of nodes reaches one gateway.
+ */
+
+#include <zephyr.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+#include <settings/settings.h>
+#include <sys/printk.h>
+#include <sys/byteorder.h>
+#include <sys/util.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mesh_sensor.h"
+#include "sample_ring.h"
+#include "snapshot.h"
+
+#define OP_DESCRIPTOR_GET    BT_MESH_MODEL_OP_2(0x82, 0x30)
+#define OP_DESCRIPTOR_STATUS BT_MESH_MODEL_OP_1(0x51)
+#define OP_SENSOR_GET        BT_MESH_MODEL_OP_2(0x82, 0x31)
+#define OP_SENSOR_STATUS     BT_MESH_MODEL_OP_1(0x52)
+#define OP_COLUMN_GET        BT_MESH_MODEL_OP_2(0x82, 0x32)
+#define OP_COLUMN_STATUS     BT_MESH_MODEL_OP_1(0x53)
+#define OP_SERIES_GET        BT_MESH_MODEL_OP_2(0x82, 0x33)
+#define OP_SERIES_STATUS     BT_MESH_MODEL_OP_1(0x54)
+#define OP_CADENCE_GET       BT_MESH_MODEL_OP_2(0x82, 0x34)
+#define OP_CADENCE_SET       BT_MESH_MODEL_OP_1(0x55)
+#define OP_CADENCE_SET_UNACK BT_MESH_MODEL_OP_1(0x56)
+#define OP_CADENCE_STATUS    BT_MESH_MODEL_OP_1(0x57)
+#define OP_SETTINGS_GET      BT_MESH_MODEL_OP_2(0x82, 0x35)
+#define OP_SETTINGS_STATUS   BT_MESH_MODEL_OP_1(0x58)
+#define OP_SETTING_GET       BT_MESH_MODEL_OP_2(0x82, 0x36)
+#define OP_SETTING_STATUS    BT_MESH_MODEL_OP_1(0x5b)
+
+#define DESCRIPTOR_LEN   8
+#define MARSHALLED_MAX   (2 + 2)  /* format A header + the widest value */
+#define CADENCE_MAX      (2 + 1 + 4 * 2 + 1)
+#define MIN_INTERVAL_MAX 26       /* 2^26 ms, the largest the spec allows */
+
+#define TRIGGER_DELTA_VALUE   0  /* deltas in property units */
+#define TRIGGER_DELTA_PERCENT 1  /* deltas in 0.01 % of the published value */
+
+#define SAMPLING_INSTANTANEOUS 0x01
+
+/* Sensor Cadence state of one property */
+struct cadence {
+    uint8_t divisor;       /* fast period = publish period >> divisor */
+    uint8_t trigger_type;  /* TRIGGER_DELTA_* */
+    int32_t delta_down;
+    int32_t delta_up;
+    uint8_t min_interval;  /* 2^n ms between delta-triggered publications */
+    int32_t fast_low;
+    int32_t fast_high;
+};
+
+struct mesh_prop {
+    uint16_t id;
+    uint8_t len;       /* value bytes */
+    bool is_signed;
+    int32_t unknown;   /* raw value meaning "not known" */
+    int32_t value;
+    int32_t published; /* value in the last Sensor Status published */
+    uint32_t last_pub_ms;
+    bool triggered;    /* delta exceeded, waiting for min_interval */
+    struct cadence cad;
+};
+
+enum {
+    PROP_TEMP,
+    PROP_HUM,
+    PROP_VOC,
+#ifdef CONFIG_SOUND_ADC
+    PROP_NOISE,
+#endif
+    PROP_COUNT
+};
+
+/* Delta triggers and minimum intervals keep a still room quiet: a node
+ * only speaks at its publication period unless a reading moves.
+ */
+static struct mesh_prop props[PROP_COUNT] = {
+    [PROP_TEMP] = {
+        .id = MESH_PROP_PRESENT_AMB_TEMP, .len = 1, .is_signed = true, .unknown = 0x7f,
+        .cad = { .delta_down = 2, .delta_up = 2, .min_interval = 13 },
+    },
+    [PROP_HUM] = {
+        .id = MESH_PROP_PRESENT_AMB_REL_HUMIDITY, .len = 2, .unknown = 0xffff,
+        .cad = { .delta_down = 500, .delta_up = 500, .min_interval = 13 },
+    },
+    [PROP_VOC] = {
+        .id = MESH_PROP_PRESENT_AMB_VOC_CONC, .len = 2, .unknown = 0xffff,
+        .cad = { .trigger_type = TRIGGER_DELTA_PERCENT, .delta_down = 2000, .delta_up = 2000,
+                 .min_interval = 13 },
+    },
+#ifdef CONFIG_SOUND_ADC
+    [PROP_NOISE] = {
+        .id = MESH_PROP_PRESENT_AMB_NOISE, .len = 1, .unknown = 0xff,
+        .cad = { .delta_down = 6, .delta_up = 6, .min_interval = 12 },
+    },
+#endif
+};
+
+static struct sample_consumer mesh_consumer;
+static struct bt_mesh_model *srv_model;
+static struct k_work_delayable pub_work;
+
+static struct mesh_prop *find_prop(uint16_t id) {
+    for (int i = 0; i < PROP_COUNT; i++) {
+        if (props[i].id == id) return &props[i];
+    }
+    return NULL;
+}
+
+static void put_value(struct net_buf_simple *buf, int32_t v, uint8_t len) {
+    if (len == 1) {
+        net_buf_simple_add_u8(buf, (uint8_t)v);
+    } else {
+        net_buf_simple_add_le16(buf, (uint16_t)v);
+    }
+}
+
+static int32_t pull_value(struct net_buf_simple *buf, uint8_t len, bool is_signed) {
+    if (len == 1) {
+        uint8_t v = net_buf_simple_pull_u8(buf);
+        return is_signed ? (int8_t)v : v;
+    }
+
+    uint16_t v = net_buf_simple_pull_le16(buf);
+    return is_signed ? (int16_t)v : v;
+}
+
+/* Marshalled Sensor Data, format A: 1 bit format, 4 bits length - 1,
+ * 11 bits property ID
+ */
+static void put_marshalled(struct net_buf_simple *buf, const struct mesh_prop *p) {
+    net_buf_simple_add_le16(buf, ((p->len - 1) << 1) | (p->id << 5));
+    put_value(buf, p->value, p->len);
+}
+
+/* Format B with length 0x7f: the property is not supported */
+static void put_unknown_prop(struct net_buf_simple *buf, uint16_t id) {
+    net_buf_simple_add_u8(buf, 0xff);
+    net_buf_simple_add_le16(buf, id);
+}
+
+/* ---- Cadence ---- */
+
+static bool in_fast_range(const struct mesh_prop *p) {
+    const struct cadence *c = &p->cad;
+
+    if (p->value == p->unknown || !c->divisor) return false;
+    if (c->fast_high >= c->fast_low) {
+        return p->value >= c->fast_low && p->value <= c->fast_high;
+    }
+    return p->value < c->fast_high || p->value > c->fast_low;
+}
+
+static bool delta_exceeded(const struct mesh_prop *p) {
+    const struct cadence *c = &p->cad;
+    int32_t diff = p->value - p->published;
+
+    if (p->value == p->unknown) return false;
+    if (p->published == p->unknown) return true;
+    if (!diff) return false;
+
+    int32_t delta = diff > 0 ? c->delta_up : c->delta_down;
+
+    if (c->trigger_type == TRIGGER_DELTA_PERCENT) {
+        /* delta in 0.01 % of the last published value */
+        return (int64_t)abs(diff) * 10000 >= (int64_t)delta * abs(p->published);
+    }
+    return delta > 0 && abs(diff) >= delta;
+}
+
+/* Publication period of one property; fast cadence never goes below the
+ * status minimum interval, so a misconfigured divisor cannot flood the
+ * network.
+ */
+static uint32_t prop_period(const struct mesh_prop *p, int32_t base) {
+    uint32_t period;
+
+    if (base <= 0) return 0;
+
+    period = in_fast_range(p) ? (uint32_t)base >> p->cad.divisor : (uint32_t)base;
+    return MAX(period, BIT(p->cad.min_interval));
+}
+
+/* Publishes every property that is due in one Sensor Status, then sleeps
+ * until the next one is
+ */
+static void pub_handler(struct k_work *work) {
+    struct net_buf_simple *msg = srv_model->pub->msg;
+    int32_t base = bt_mesh_model_pub_period_get(srv_model);
+    uint32_t now = k_uptime_get_32();
+    uint32_t next = UINT32_MAX;
+    int due = 0;
+
+    bt_mesh_model_msg_init(msg, OP_SENSOR_STATUS);
+
+    for (int i = 0; i < PROP_COUNT; i++) {
+        struct mesh_prop *p = &props[i];
+        uint32_t elapsed = now - p->last_pub_ms;
+        uint32_t period = prop_period(p, base);
+        uint32_t wait = UINT32_MAX;
+
+        if (p->triggered) {
+            uint32_t min = BIT(p->cad.min_interval);
+
+            wait = elapsed >= min ? 0 : min - elapsed;
+        }
+        if (period) {
+            wait = MIN(wait, elapsed >= period ? 0 : period - elapsed);
+        }
+
+        if (wait == 0) {
+            put_marshalled(msg, p);
+            p->published = p->value;
+            p->last_pub_ms = now;
+            p->triggered = false;
+            due++;
+            wait = period ? period : UINT32_MAX;
+        }
+        next = MIN(next, wait);
+    }
+
+    if (due) {
+        int err = bt_mesh_model_publish(srv_model);
+
+        /* Unconfigured publication is the normal state before a gateway
+         * sets it up
+         */
+        if (err && err != -EADDRNOTAVAIL) {
+            printk("Sensor Status publish failed (err %d)\n", err);
+        }
+    }
+
+    if (next != UINT32_MAX) {
+        k_work_reschedule(&pub_work, K_MSEC(next));
+    }
+}
+
+/* Called by the access layer at every publication period, and when the
+ * period is reconfigured; timing is ours, so it only wakes the worker.
+ */
+static int pub_update(struct bt_mesh_model *mod) {
+    k_work_reschedule(&pub_work, K_NO_WAIT);
+    return -EALREADY;
+}
+
+BT_MESH_MODEL_PUB_DEFINE(sensor_pub, pub_update, 1 + PROP_COUNT * MARSHALLED_MAX);
+
+/* ---- Sensor Server ---- */
+
+static int descriptor_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_DESCRIPTOR_STATUS, PROP_COUNT * DESCRIPTOR_LEN);
+
+    bt_mesh_model_msg_init(&msg, OP_DESCRIPTOR_STATUS);
+
+    for (int i = 0; i < PROP_COUNT; i++) {
+        if (buf->len == 2 && props[i].id != sys_get_le16(buf->data)) continue;
+
+        net_buf_simple_add_le16(&msg, props[i].id);
+        net_buf_simple_add_le24(&msg, 0);  /* tolerances unspecified */
+        net_buf_simple_add_u8(&msg, SAMPLING_INSTANTANEOUS);
+        net_buf_simple_add_u8(&msg, 0);    /* measurement period n/a */
+        net_buf_simple_add_u8(&msg, 0);    /* update interval n/a */
+    }
+
+    if (buf->len == 2 && msg.len == 1) {
+        net_buf_simple_add_le16(&msg, sys_get_le16(buf->data));
+    }
+
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int sensor_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_STATUS, PROP_COUNT * MARSHALLED_MAX);
+
+    bt_mesh_model_msg_init(&msg, OP_SENSOR_STATUS);
+
+    if (buf->len == 2) {
+        uint16_t id = net_buf_simple_pull_le16(buf);
+        struct mesh_prop *p = find_prop(id);
+
+        if (p) {
+            put_marshalled(&msg, p);
+        } else {
+            put_unknown_prop(&msg, id);
+        }
+    } else {
+        for (int i = 0; i < PROP_COUNT; i++) {
+            put_marshalled(&msg, &props[i]);
+        }
+    }
+
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+/* No property here has columns or series: the status echoes the request */
+static int column_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_COLUMN_STATUS, 2 + 2);
+
+    bt_mesh_model_msg_init(&msg, OP_COLUMN_STATUS);
+    net_buf_simple_add_mem(&msg, buf->data, MIN(buf->len, 2 + 2));
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int series_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_SERIES_STATUS, 2);
+
+    bt_mesh_model_msg_init(&msg, OP_SERIES_STATUS);
+    net_buf_simple_add_le16(&msg, net_buf_simple_pull_le16(buf));
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static const struct bt_mesh_model_op sensor_srv_op[] = {
+    { OP_DESCRIPTOR_GET, BT_MESH_LEN_MIN(0), descriptor_get },
+    { OP_SENSOR_GET, BT_MESH_LEN_MIN(0), sensor_get },
+    { OP_COLUMN_GET, BT_MESH_LEN_MIN(2), column_get },
+    { OP_SERIES_GET, BT_MESH_LEN_MIN(2), series_get },
+    BT_MESH_MODEL_OP_END,
+};
+
+/* ---- Sensor Setup Server ---- */
+
+static void put_cadence(struct net_buf_simple *msg, const struct mesh_prop *p) {
+    const struct cadence *c = &p->cad;
+    uint8_t delta_len = c->trigger_type == TRIGGER_DELTA_PERCENT ? 2 : p->len;
+
+    net_buf_simple_add_le16(msg, p->id);
+    net_buf_simple_add_u8(msg, c->divisor | (c->trigger_type << 7));
+    put_value(msg, c->delta_down, delta_len);
+    put_value(msg, c->delta_up, delta_len);
+    net_buf_simple_add_u8(msg, c->min_interval);
+    put_value(msg, c->fast_low, p->len);
+    put_value(msg, c->fast_high, p->len);
+}
+
+static int cadence_status_send(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, uint16_t id) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_CADENCE_STATUS, CADENCE_MAX);
+    struct mesh_prop *p = find_prop(id);
+
+    bt_mesh_model_msg_init(&msg, OP_CADENCE_STATUS);
+    if (p) {
+        put_cadence(&msg, p);
+    } else {
+        net_buf_simple_add_le16(&msg, id);
+    }
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int cadence_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    return cadence_status_send(model, ctx, net_buf_simple_pull_le16(buf));
+}
+
+static int cadence_apply(struct net_buf_simple *buf, uint16_t *id) {
+    struct cadence c;
+    struct mesh_prop *p;
+    uint8_t delta_len;
+
+    *id = net_buf_simple_pull_le16(buf);
+    p = find_prop(*id);
+    if (!p) return -ENOENT;
+
+    uint8_t div_type = net_buf_simple_pull_u8(buf);
+
+    c.divisor = div_type & BIT_MASK(7);
+    c.trigger_type = div_type >> 7;
+    delta_len = c.trigger_type == TRIGGER_DELTA_PERCENT ? 2 : p->len;
+    if (c.divisor > 15 || buf->len != 2 * delta_len + 1 + 2 * p->len) return -EINVAL;
+
+    c.delta_down = pull_value(buf, delta_len, p->is_signed && !c.trigger_type);
+    c.delta_up = pull_value(buf, delta_len, p->is_signed && !c.trigger_type);
+    c.min_interval = net_buf_simple_pull_u8(buf);
+    if (c.min_interval > MIN_INTERVAL_MAX) return -EINVAL;
+    c.fast_low = pull_value(buf, p->len, p->is_signed);
+    c.fast_high = pull_value(buf, p->len, p->is_signed);
+
+    p->cad = c;
+    printk("Cadence 0x%04x: div %u, trigger %u, delta -%d/+%d, min 2^%u ms\n", p->id,
+           c.divisor, c.trigger_type, c.delta_down, c.delta_up, c.min_interval);
+
+    k_work_reschedule(&pub_work, K_NO_WAIT);
+    return 0;
+}
+
+static int cadence_set(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    uint16_t id;
+    int err = cadence_apply(buf, &id);
+
+    if (err == -EINVAL) return err;  /* prohibited values: no response */
+    return cadence_status_send(model, ctx, id);
+}
+
+static int cadence_set_unack(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    uint16_t id;
+    int err = cadence_apply(buf, &id);
+
+    return err == -ENOENT ? 0 : err;
+}
+
+/* No settings are exposed: statuses carry the property (and setting) ID only */
+static int settings_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_SETTINGS_STATUS, 2);
+
+    bt_mesh_model_msg_init(&msg, OP_SETTINGS_STATUS);
+    net_buf_simple_add_le16(&msg, net_buf_simple_pull_le16(buf));
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int setting_get(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf) {
+    BT_MESH_MODEL_BUF_DEFINE(msg, OP_SETTING_STATUS, 4);
+
+    bt_mesh_model_msg_init(&msg, OP_SETTING_STATUS);
+    net_buf_simple_add_mem(&msg, buf->data, 4);
+    return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static const struct bt_mesh_model_op sensor_setup_op[] = {
+    { OP_CADENCE_GET, BT_MESH_LEN_EXACT(2), cadence_get },
+    { OP_CADENCE_SET, BT_MESH_LEN_MIN(2), cadence_set },
+    { OP_CADENCE_SET_UNACK, BT_MESH_LEN_MIN(2), cadence_set_unack },
+    { OP_SETTINGS_GET, BT_MESH_LEN_EXACT(2), settings_get },
+    { OP_SETTING_GET, BT_MESH_LEN_EXACT(4), setting_get },
+    BT_MESH_MODEL_OP_END,
+};
+
+BT_MESH_MODEL_PUB_DEFINE(setup_pub, NULL, 1 + CADENCE_MAX);
+
+/* ---- Node ---- */
+
+static struct bt_mesh_health_srv health_srv;
+BT_MESH_HEALTH_PUB_DEFINE(health_pub, 0);
+
+#ifdef CONFIG_APP_MESH_SELF_PROV
+static struct bt_mesh_cfg_cli cfg_cli;
+#endif
+
+static struct bt_mesh_model root_models[] = {
+    BT_MESH_MODEL_CFG_SRV,
+#ifdef CONFIG_APP_MESH_SELF_PROV
+    BT_MESH_MODEL_CFG_CLI(&cfg_cli),
+#endif
+    BT_MESH_MODEL_HEALTH_SRV(&health_srv, &health_pub),
+    BT_MESH_MODEL(BT_MESH_MODEL_ID_SENSOR_SRV, sensor_srv_op, &sensor_pub, NULL),
+    BT_MESH_MODEL(BT_MESH_MODEL_ID_SENSOR_SETUP_SRV, sensor_setup_op, &setup_pub, NULL),
+};
+
+static struct bt_mesh_elem elements[] = {
+    BT_MESH_ELEM(0, root_models, BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+    .cid = BT_COMP_ID_LF,
+    .elem = elements,
+    .elem_count = ARRAY_SIZE(elements),
+};
+
+static uint8_t dev_uuid[16] = { 'S', 'o', 'm', 'n', 'o', 'S', 'n', 's' };
+
+static void prov_complete(uint16_t net_idx, uint16_t addr) {
+    printk("Provisioned, address 0x%04x\n", addr);
+}
+
+static void prov_reset(void) {
+    bt_mesh_prov_enable(BT_MESH_PROV_ADV | BT_MESH_PROV_GATT);
+}
+
+static const struct bt_mesh_prov prov = {
+    .uuid = dev_uuid,
+    .complete = prov_complete,
+    .reset = prov_reset,
+};
+
+/* ---- Readings ---- */
+
+static void set_value(struct mesh_prop *p, int32_t v) {
+    p->value = v;
+    if (delta_exceeded(p)) {
+        p->triggered = true;
+        k_work_reschedule(&pub_work, K_NO_WAIT);
+    }
+}
+
+static void mesh_consumer_handler(struct k_work *work) {
+    struct sample smp;
+
+    while (sample_ring_read(&mesh_consumer.reader, &smp) == 0) {
+        switch (smp.kind) {
+        case SAMPLE_ENV:
+            set_value(&props[PROP_TEMP], CLAMP((int32_t)lroundf(smp.env.temp_c * 2.0f), -128, 126));
+            set_value(&props[PROP_HUM], MIN(snapshot_centi_u16(smp.env.hum_pct), 10000));
+            break;
+        case SAMPLE_GAS:
+            /* The MGS ethanol channel is the closest to a VOC reading */
+            set_value(&props[PROP_VOC], (smp.gas.valid & BIT(GAS_CH_ETOH)) ?
+                      (int32_t)MIN(smp.gas.etoh * 1000.0f, 65534.0f) : props[PROP_VOC].unknown);
+            break;
+#ifdef CONFIG_SOUND_ADC
+        case SAMPLE_SOUND_LEVEL: {
+            int32_t db = smp.sound_level.dbfs_centi == INT16_MIN ? 0 :
+                         smp.sound_level.dbfs_centi / 100 + CONFIG_APP_MESH_NOISE_OFFSET_DB;
+
+            set_value(&props[PROP_NOISE], CLAMP(db, 0, 254));
+            break;
+        }
+#endif
+        default:
+            break;
+        }
+    }
+}
+
+#ifdef CONFIG_APP_MESH_SELF_PROV
+/* Fixed test keys, so nodes in a simulation form one network without a
+ * provisioner. Never ship them.
+ */
+static const uint8_t net_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x4e, 0x65, 0x74, 0x4b, 0x65, 0x79 };
+static const uint8_t dev_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x44, 0x65, 0x76, 0x4b, 0x65, 0x79 };
+static const uint8_t app_key[16] = { 0x53, 0x6f, 0x6d, 0x6e, 0x6f, 0x53, 0x65, 0x6e,
+                                     0x73, 0x65, 0x41, 0x70, 0x70, 0x4b, 0x65, 0x79 };
+
+static int self_provision(uint16_t addr) {
+    struct bt_mesh_cfg_mod_pub pub = {
+        .addr = CONFIG_APP_MESH_GROUP_ADDR,
+        .app_idx = 0,
+        .ttl = BT_MESH_TTL_DEFAULT,
+        .period = CONFIG_APP_MESH_PUB_PERIOD_S <= 63 ?
+                  BT_MESH_PUB_PERIOD_SEC(CONFIG_APP_MESH_PUB_PERIOD_S) :
+                  BT_MESH_PUB_PERIOD_10SEC(CONFIG_APP_MESH_PUB_PERIOD_S / 10),
+        .transmit = BT_MESH_TRANSMIT(1, 20),
+    };
+    uint8_t status;
+    int err;
+
+    err = bt_mesh_provision(net_key, 0, 0, 0, addr, dev_key);
+    if (err) return err;
+
+    /* Configured through our own Configuration Server, over loopback */
+    err = bt_mesh_cfg_app_key_add(0, addr, 0, 0, app_key, &status);
+    if (err) return err;
+    err = bt_mesh_cfg_mod_app_bind(0, addr, addr, 0, BT_MESH_MODEL_ID_SENSOR_SRV, &status);
+    if (err) return err;
+    err = bt_mesh_cfg_mod_app_bind(0, addr, addr, 0, BT_MESH_MODEL_ID_SENSOR_SETUP_SRV, &status);
+    if (err) return err;
+    return bt_mesh_cfg_mod_pub_set(0, addr, addr, BT_MESH_MODEL_ID_SENSOR_SRV, &pub, &status);
+}
+#endif /* CONFIG_APP_MESH_SELF_PROV */
+
+int mesh_sensor_init(void) {
+    bt_addr_le_t id;
+    size_t count = 1;
+    int err;
+
+    err = bt_enable(NULL);
+    if (err) return err;
+
+    /* The identity address tells nodes apart in the unprovisioned beacon */
+    bt_id_get(&id, &count);
+    memcpy(&dev_uuid[10], id.a.val, sizeof(id.a.val));
+
+    for (int i = 0; i < PROP_COUNT; i++) {
+        props[i].value = props[i].unknown;
+        props[i].published = props[i].unknown;
+    }
+    k_work_init_delayable(&pub_work, pub_handler);
+
+    err = bt_mesh_init(&prov, &comp);
+    if (err) return err;
+
+    srv_model = bt_mesh_model_find(&elements[0], BT_MESH_MODEL_ID_SENSOR_SRV);
+    sample_ring_subscribe(&mesh_consumer, NULL, mesh_consumer_handler);
+
+    if (IS_ENABLED(CONFIG_SETTINGS)) {
+        settings_load();
+    }
+
+    if (bt_mesh_is_provisioned()) {
+        k_work_reschedule(&pub_work, K_NO_WAIT);
+        return 0;
+    }
+
+#ifdef CONFIG_APP_MESH_SELF_PROV
+    /* Unicast address from the identity address, never 0 or a group */
+    err = self_provision(MAX(sys_get_le16(id.a.val) & 0x7fff, 1));
+    if (!err) k_work_reschedule(&pub_work, K_NO_WAIT);
+    return err;
+#else
+    return bt_mesh_prov_enable(BT_MESH_PROV_ADV | BT_MESH_PROV_GATT);
+#endif
+}
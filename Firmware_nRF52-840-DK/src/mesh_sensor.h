@@ -0,0 +1,20 @@
+#ifndef MESH_SENSOR_H
+#define MESH_SENSOR_H
+
+#include <zephyr/types.h>
+
+/* Mesh Device Properties published by the Sensor Server */
+#define MESH_PROP_PRESENT_AMB_TEMP         0x004f  /* Temperature 8: sint8, 0.5 C */
+#define MESH_PROP_PRESENT_AMB_REL_HUMIDITY 0x0076  /* Humidity: uint16, 0.01 % */
+#define MESH_PROP_PRESENT_AMB_VOC_CONC     0x0078  /* Concentration: uint16, ppb */
+#define MESH_PROP_PRESENT_AMB_NOISE        0x0079  /* Noise: uint8, dB */
+
+/**
+ * @brief Enables Bluetooth and Mesh, subscribes the Sensor Server to the
+ *        sample ring and makes the node provisionable (or provisions it
+ *        with the test keys under CONFIG_APP_MESH_SELF_PROV).
+ * @return 0 on success, negative error code otherwise.
+ */
+int mesh_sensor_init(void);
+
+#endif
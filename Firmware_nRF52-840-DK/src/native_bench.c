@@ -0,0 +1,270 @@
+/* native_bench.c - Host timing driver for the portable pipeline code
+ *
+ * Built only by the PlatformIO native environment (pio run -e native -t
+ * exec), against the header shims in native/include; the Zephyr builds
+ * never list it. Runs the synthetic readings, sample ring, snapshot,
+ * batch framing, flash codec and sound level code over sets far larger
+ * than the target has room for, and prints the same lines as bench.c with
+ * nanoseconds in every column:
+ *
+ *   BENCH,<name>,<operations>,<min ns>,<avg ns>,<max ns>,<avg ns>
+ *   CODEC,<records>,<raw float bytes>,<v1 fixed bytes>,<v2 bytes>,<raw/v2 x100>,<mismatches>
+ *
+ * min and max are over chunks of CHUNK operations. Every decoded record
+ * is compared with the original at codec resolution; the exit status is
+ * non-zero if any differs. The unit tests in test/ link the same sources
+ * (pio test -e native) and leave this driver out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sample_ring.h"
+#include "sample_codec.h"
+#include "snapshot.h"
+#include "sound_level.h"
+#include "synth_sensors.h"
+
+#ifndef PIO_UNIT_TESTING
+#define RECORDS       (1u << 18)  /* three days of gas and env at one record a second */
+#define CHUNK         1024
+#define BLOCK_MAX     240         /* SAMPLE_STORE_BLOCK_MAX */
+#define BLOCK_HDR_LEN 12          /* SAMPLE_STORE_BLOCK_HDR_LEN */
+#define LEVEL_BLOCK   128         /* default SOUND_ADC_BLOCK_SAMPLES */
+
+/* Record sizes of the other encodings, as bench.c counts them */
+#define RAW_GAS_LEN     (4 + 1 + 5 * 4)
+#define RAW_ENV_LEN     (4 + 1 + 2 * 4)
+#define FIXED_GAS_LEN   (3 + 1 + 5 * 2)
+#define FIXED_ENV_LEN   (3 + 2 * 2)
+
+typedef void (*stage_fn_t)(size_t i);
+
+/* Encoded flash log of the whole set, blocks back to back */
+struct block_ref {
+    uint32_t offset;
+    uint16_t len;
+    uint8_t count;
+    uint32_t base_ms;
+};
+
+static struct sample set[RECORDS];
+static struct snapshot_state snap;
+static struct snapshot_batch batch;
+static uint8_t record[SNAPSHOT_LEN];
+
+/* Worst case: one record per block at its largest */
+static uint8_t log_buf[RECORDS * (BLOCK_HDR_LEN + SAMPLE_CODEC_RECORD_MAX)];
+static struct block_ref blocks[RECORDS];
+static size_t block_count, log_len;
+static struct sample_codec enc;
+
+static int16_t level_signal[LEVEL_BLOCK * 64];
+static struct sound_level_acc level_acc;
+static struct sample_reader reader;
+
+static uint64_t now_ns(void)
+{
+    return native_clock_ns();
+}
+
+static void measure(const char *name, stage_fn_t fn, size_t count)
+{
+    uint64_t total = 0, min = UINT64_MAX, max = 0;
+
+    for (size_t base = 0; base < count; base += CHUNK) {
+        size_t n = MIN(CHUNK, count - base);
+        uint64_t start = now_ns();
+
+        for (size_t i = base; i < base + n; i++) {
+            fn(i);
+        }
+
+        uint64_t elapsed = now_ns() - start;
+        uint64_t per_op = elapsed / n;
+
+        total += elapsed;
+        min = MIN(min, per_op);
+        max = MAX(max, per_op);
+    }
+
+    printf("BENCH,%s,%zu,%llu,%llu,%llu,%llu\n", name, count,
+           (unsigned long long)min, (unsigned long long)(total / count),
+           (unsigned long long)max, (unsigned long long)(total / count));
+}
+
+/* Gas and env records alternating on a one second grid */
+static void stage_acquire(size_t i)
+{
+    struct sample *smp = &set[i];
+
+    smp->seq = i + 1;
+    smp->timestamp_ms = i * 1000;
+    if (i & 1) {
+        smp->kind = SAMPLE_ENV;
+        synth_read_env(&smp->env.temp_c, &smp->env.hum_pct);
+    } else {
+        smp->kind = SAMPLE_GAS;
+        synth_read_gas(&smp->gas);
+    }
+}
+
+/* The ring stamps seq and time itself; publish a copy so set[] keeps the
+ * acquisition grid the codec stage encodes
+ */
+static void stage_ring_publish(size_t i)
+{
+    struct sample smp = set[i];
+
+    sample_ring_publish(&smp);
+}
+
+static void stage_ring_read(size_t i)
+{
+    struct sample smp;
+
+    (void)sample_ring_read(&reader, &smp);
+}
+
+static void stage_snapshot_update(size_t i)
+{
+    (void)snapshot_update(&snap, &set[i]);
+}
+
+static void stage_snapshot_encode(size_t i)
+{
+    (void)snapshot_encode(&snap, record);
+}
+
+static void stage_snapshot_batch(size_t i)
+{
+    if (snapshot_batch_add(&batch, record) == SNAPSHOT_BATCH_MAX) {
+        (void)snapshot_batch_take(&batch);
+    }
+}
+
+/* Fills blocks the way sample_store does: a new one when the next record
+ * might not fit
+ */
+static void stage_codec_encode(size_t i)
+{
+    struct block_ref *b = &blocks[block_count];
+
+    if (b->count && b->len + SAMPLE_CODEC_RECORD_MAX > BLOCK_MAX) {
+        log_len += b->len;
+        b = &blocks[++block_count];
+    }
+    if (!b->count) {
+        b->offset = log_len;
+        b->len = BLOCK_HDR_LEN;
+        b->base_ms = set[i].timestamp_ms;
+        sample_codec_reset(&enc, b->base_ms);
+    }
+
+    b->len += sample_codec_encode(&enc, &set[i], &log_buf[b->offset + b->len],
+                                  SAMPLE_CODEC_RECORD_MAX);
+    b->count++;
+}
+
+static void stage_level_feed(size_t i)
+{
+    size_t at = (i * LEVEL_BLOCK) % ARRAY_SIZE(level_signal);
+
+    sound_level_feed(&level_acc, &level_signal[at], LEVEL_BLOCK);
+}
+
+/* Same fields at the 0.01 resolution the codec keeps */
+static bool same_quantized(const struct sample *a, const struct sample *b)
+{
+    if (a->kind != b->kind || a->timestamp_ms != b->timestamp_ms) {
+        return false;
+    }
+    if (a->kind == SAMPLE_ENV) {
+        return snapshot_centi_i16(a->env.temp_c) == snapshot_centi_i16(b->env.temp_c) &&
+               snapshot_centi_u16(a->env.hum_pct) == snapshot_centi_u16(b->env.hum_pct);
+    }
+    return a->gas.valid == b->gas.valid &&
+           snapshot_centi_u16(a->gas.co) == snapshot_centi_u16(b->gas.co) &&
+           snapshot_centi_u16(a->gas.no2) == snapshot_centi_u16(b->gas.no2) &&
+           snapshot_centi_u16(a->gas.nh3) == snapshot_centi_u16(b->gas.nh3) &&
+           snapshot_centi_u16(a->gas.ch4) == snapshot_centi_u16(b->gas.ch4) &&
+           snapshot_centi_u16(a->gas.etoh) == snapshot_centi_u16(b->gas.etoh);
+}
+
+/* Decodes every block; each record must match the set[] entry it was
+ * encoded from
+ */
+static uint32_t codec_check(size_t *decoded)
+{
+    uint32_t mismatches = 0;
+    uint64_t start = now_ns();
+
+    *decoded = 0;
+    for (size_t k = 0; k < block_count; k++) {
+        const struct block_ref *b = &blocks[k];
+        const uint8_t *blk = &log_buf[b->offset];
+        struct sample_codec dec;
+        size_t off = BLOCK_HDR_LEN;
+
+        sample_codec_reset(&dec, b->base_ms);
+        for (uint8_t r = 0; r < b->count; r++) {
+            struct sample out = { 0 };
+            int n = sample_codec_decode(&dec, &blk[off], b->len - off, &out);
+
+            if (n <= 0 || !same_quantized(&set[*decoded], &out)) {
+                mismatches++;
+                break;
+            }
+            off += n;
+            (*decoded)++;
+        }
+    }
+
+    uint64_t elapsed = now_ns() - start;
+    unsigned long long per_op = *decoded ? elapsed / *decoded : 0;
+
+    printf("BENCH,codec_decode_check,%zu,%llu,%llu,%llu,%llu\n", *decoded,
+           per_op, per_op, per_op, per_op);
+    return mismatches;
+}
+
+int main(void)
+{
+    size_t decoded;
+    uint32_t mismatches, raw = 0, fixed = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(level_signal); i++) {
+        level_signal[i] = (int16_t)(2048 + ((i * 37) % 512) - 256);
+    }
+
+    printf("BENCH,board,native\n");
+    measure("synth_acquire", stage_acquire, RECORDS);
+    sample_reader_init(&reader);
+    measure("ring_publish", stage_ring_publish, RECORDS);
+    /* Only the last ring's worth is still there; the rest counts as lost */
+    measure("ring_read", stage_ring_read, CONFIG_SAMPLE_RING_SIZE);
+    measure("snapshot_update", stage_snapshot_update, RECORDS);
+    measure("snapshot_encode", stage_snapshot_encode, RECORDS);
+    measure("snapshot_batch", stage_snapshot_batch, RECORDS);
+    measure("codec_encode", stage_codec_encode, RECORDS);
+    log_len += blocks[block_count].len;
+    block_count++;
+
+    sound_level_reset(&level_acc);
+    measure("sound_level_block", stage_level_feed, RECORDS);
+
+    mismatches = codec_check(&decoded);
+    for (size_t i = 0; i < RECORDS; i++) {
+        raw += set[i].kind == SAMPLE_GAS ? RAW_GAS_LEN : RAW_ENV_LEN;
+        fixed += set[i].kind == SAMPLE_GAS ? FIXED_GAS_LEN : FIXED_ENV_LEN;
+    }
+    fixed += block_count * BLOCK_HDR_LEN;
+    printf("CODEC,%u,%u,%u,%zu,%zu,%u\n", RECORDS, raw, fixed, log_len,
+           raw * 100 / log_len, mismatches);
+    printf("BENCH,done\n");
+
+    return mismatches || decoded != RECORDS;
+}
+#endif /* PIO_UNIT_TESTING */
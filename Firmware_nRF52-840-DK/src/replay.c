@@ -0,0 +1,419 @@
+/* replay.c - Recorded dataset replay for host builds
+ *
+ * Plays a CSV export of the room recorder (date_time, temperature,
+ * humidity, sound_amp; other columns such as light have no sensor here
+ * and are skipped) into the emulated sensors, following the recorded
+ * timestamps divided by the speedup. The DHT11 emulator answers the
+ * recorded temperature and humidity, rows at or above the sound threshold
+ * pulse the sound module input and sound_amp sets the amplitude of the
+ * emulated ADC signal. Everything from the drivers on runs unchanged.
+ *
+ * Once per recorded hour it prints
+ *
+ *   REPLAY,hour,rows,samples,notif_live,notif_batch,radio_us_live,
+ *          radio_us_batch,ble_sent,host_cpu_us
+ *
+ * notif_* and radio_us_* are what one subscribed central would cost in
+ * live and full-batch mode, counted from the snapshot changes; ble_sent
+ * is what the stack really sent to centrals attached with --bt-dev.
+ * host_cpu_us is the process CPU time, only meaningful to compare two
+ * builds; target cycle costs come from APP_BENCH.
+ */
+
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/gpio.h>
+#include <drivers/gpio/gpio_emul.h>
+#ifdef CONFIG_SOUND_ADC
+#include <drivers/adc.h>
+#include <drivers/adc/adc_emul.h>
+#endif
+#include <sys/printk.h>
+#include <sys/util.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "cmdline.h"
+#include "soc.h"
+#include "posix_board_if.h"
+
+#include "dht_emul.h"
+#include "replay.h"
+#include "sample_ring.h"
+#include "snapshot.h"
+#include "ble_manager.h"
+
+#define REPLAY_STACK_SIZE 2048
+#define REPLAY_PRIORITY   7
+#define REPLAY_LINE_MAX   256
+#define REPLAY_HOUR_S     3600
+#define PULSE_MS          5
+
+/* Air time of one notification and its empty acknowledgement: preamble,
+ * access address, header and CRC around the L2CAP and ATT headers, plus
+ * two inter-frame spaces.
+ */
+#ifdef CONFIG_BLE_BATCH_PHY_2M
+#define LL_OVERHEAD  11
+#define US_PER_BYTE  4
+#else
+#define LL_OVERHEAD  10
+#define US_PER_BYTE  8
+#endif
+#define ATT_OVERHEAD 7
+#define T_IFS_US     150
+
+#define DHT_NODE   DT_ALIAS(dht11)
+#define SOUND_NODE DT_NODELABEL(sound_node)
+
+static const struct device *dht_dev = DEVICE_DT_GET(DHT_NODE);
+static const struct gpio_dt_spec sound_gpio = GPIO_DT_SPEC_GET(SOUND_NODE, gpios);
+
+#ifdef CONFIG_SOUND_ADC
+#define SOUND_ADC_NODE DT_PATH(zephyr_user)
+
+static const struct device *adc_dev = DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(SOUND_ADC_NODE));
+static uint32_t adc_amp_mv;
+#endif
+
+enum replay_col {
+    COL_TIME,
+    COL_TEMP,
+    COL_HUM,
+    COL_SOUND,
+    COL_COUNT
+};
+
+static const char *const col_names[COL_COUNT] = {
+    [COL_TIME] = "date_time",
+    [COL_TEMP] = "temperature",
+    [COL_HUM] = "humidity",
+    [COL_SOUND] = "sound_amp",
+};
+
+/* Set from the command line before the kernel starts */
+static char *replay_file;
+static uint32_t replay_speedup = CONFIG_APP_REPLAY_SPEEDUP;
+
+static void replay_add_options(void)
+{
+    static struct args_struct_t replay_options[] = {
+        {
+            .option = "replay",
+            .name = "file",
+            .type = 's',
+            .dest = (void *)&replay_file,
+            .descript = "CSV dataset played into the emulated sensors",
+        },
+        {
+            .option = "replay-speedup",
+            .name = "factor",
+            .type = 'u',
+            .dest = (void *)&replay_speedup,
+            .descript = "Recorded seconds played per firmware second "
+                        "(CONFIG_APP_REPLAY_SPEEDUP by default)",
+        },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(replay_options);
+}
+
+NATIVE_TASK(replay_add_options, PRE_BOOT_1, 20);
+
+/* Snapshot changes seen by the ring consumer, read by the replay thread */
+static struct sample_consumer replay_consumer;
+static struct snapshot_state snapshot;
+static uint32_t snapshot_changes;
+
+struct replay_totals {
+    uint32_t rows;
+    uint32_t samples;
+    uint32_t changes;
+    uint32_t ble_sent;
+    clock_t cpu;
+};
+
+static FILE *file;
+static int cols[COL_COUNT];
+static char line[REPLAY_LINE_MAX];
+
+static K_THREAD_STACK_DEFINE(replay_stack, REPLAY_STACK_SIZE);
+static struct k_thread replay_thread_data;
+
+static void replay_consumer_handler(struct k_work *work)
+{
+    struct sample smp;
+
+    while (sample_ring_read(&replay_consumer.reader, &smp) == 0) {
+        if (snapshot_update(&snapshot, &smp)) {
+            snapshot_changes++;
+        }
+    }
+}
+
+static uint32_t notif_airtime_us(uint32_t len)
+{
+    return (LL_OVERHEAD + ATT_OVERHEAD + len) * US_PER_BYTE +
+           LL_OVERHEAD * US_PER_BYTE + 2 * T_IFS_US;
+}
+
+static void totals_get(struct replay_totals *t, uint32_t rows)
+{
+    t->rows = rows;
+    t->samples = sample_ring_published();
+    t->changes = snapshot_changes;
+    t->cpu = clock();
+#ifdef CONFIG_APP_MESH_SENSOR
+    t->ble_sent = 0;
+#else
+    struct ble_tx_stats tx;
+
+    ble_manager_get_tx_stats(&tx);
+    t->ble_sent = tx.sent;
+#endif
+}
+
+static void report(uint32_t hour, struct replay_totals *prev, uint32_t rows)
+{
+    struct replay_totals now;
+
+    totals_get(&now, rows);
+
+    uint32_t live = now.changes - prev->changes;
+    uint32_t full = live / SNAPSHOT_BATCH_MAX;
+    uint32_t rest = live % SNAPSHOT_BATCH_MAX;
+    uint32_t batch_us = full * notif_airtime_us(SNAPSHOT_BATCH_LEN(SNAPSHOT_BATCH_MAX)) +
+                        (rest ? notif_airtime_us(SNAPSHOT_BATCH_LEN(rest)) : 0);
+    uint64_t cpu_us = (uint64_t)(now.cpu - prev->cpu) * USEC_PER_SEC / CLOCKS_PER_SEC;
+
+    printk("REPLAY,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", hour,
+           now.rows - prev->rows, now.samples - prev->samples,
+           live, DIV_ROUND_UP(live, SNAPSHOT_BATCH_MAX),
+           live * notif_airtime_us(SNAPSHOT_LEN), batch_us,
+           now.ble_sent - prev->ble_sent, (uint32_t)cpu_us);
+    *prev = now;
+}
+
+/* Days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t days_from_civil(int y, int m, int d)
+{
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return (int64_t)era * 146097 + doe - 719468;
+}
+
+/* "2021-08-28 00:00:05[.xxx]", with a space or a 'T' */
+static int parse_time(const char *s, double *out)
+{
+    int y, mo, d, h, mi;
+    double sec;
+
+    if (sscanf(s, "%d-%d-%d%*c%d:%d:%lf", &y, &mo, &d, &h, &mi, &sec) != 6) {
+        return -EINVAL;
+    }
+    *out = (double)days_from_civil(y, mo, d) * 86400.0 + h * 3600 + mi * 60 + sec;
+    return 0;
+}
+
+static char *trim(char *s)
+{
+    char *end;
+
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return s;
+}
+
+/* Splits a line in place; empty fields stay empty */
+static int split(char *s, char **fields, int max)
+{
+    int n = 0;
+
+    fields[n++] = s;
+    while (n < max && (s = strchr(s, ',')) != NULL) {
+        *s++ = '\0';
+        fields[n++] = s;
+    }
+    for (int i = 0; i < n; i++) {
+        fields[i] = trim(fields[i]);
+    }
+    return n;
+}
+
+static int parse_header(void)
+{
+    char *fields[16];
+    int n;
+
+    if (!fgets(line, sizeof(line), file)) {
+        return -EINVAL;
+    }
+    n = split(line, fields, ARRAY_SIZE(fields));
+
+    for (int c = 0; c < COL_COUNT; c++) {
+        cols[c] = -1;
+        for (int i = 0; i < n; i++) {
+            if (!strcmp(fields[i], col_names[c])) {
+                cols[c] = i;
+            }
+        }
+    }
+    return cols[COL_TIME] < 0 ? -EINVAL : 0;
+}
+
+/* False when the column is absent or the field is empty */
+static bool field_value(char **fields, int n, enum replay_col col, float *out)
+{
+    char *end;
+
+    if (cols[col] < 0 || cols[col] >= n) {
+        return false;
+    }
+    *out = strtof(fields[cols[col]], &end);
+    return end != fields[cols[col]];
+}
+
+/* Physical level for a logical state, the module output is active low */
+static int sound_level(bool on)
+{
+    return (sound_gpio.dt_flags & GPIO_ACTIVE_LOW) ? !on : on;
+}
+
+static void play_row(char **fields, int n)
+{
+    static float temp = 21.0f, hum = 45.0f;
+    float amp;
+    bool have_temp = field_value(fields, n, COL_TEMP, &temp);
+    bool have_hum = field_value(fields, n, COL_HUM, &hum);
+
+    if (have_temp || have_hum) {
+        dht_emul_set(dht_dev, snapshot_centi_i16(temp), snapshot_centi_u16(hum));
+    }
+
+    if (!field_value(fields, n, COL_SOUND, &amp)) {
+        return;
+    }
+
+#ifdef CONFIG_SOUND_ADC
+    adc_amp_mv = (uint32_t)(CLAMP(amp, 0.0f, 1.0f) * 1650.0f);
+#endif
+
+    if (amp * 1000.0f >= CONFIG_APP_REPLAY_SOUND_THRESHOLD) {
+        gpio_emul_input_set(sound_gpio.port, sound_gpio.pin, sound_level(true));
+        k_sleep(K_MSEC(PULSE_MS));
+        gpio_emul_input_set(sound_gpio.port, sound_gpio.pin, sound_level(false));
+    }
+}
+
+#ifdef CONFIG_SOUND_ADC
+/* Same 1.65 V biased triangle as the default emulated signal, with the
+ * recorded amplitude
+ */
+static int replay_adc_signal(const struct device *dev, unsigned int chan, void *data,
+                             uint32_t *result)
+{
+    static uint32_t n;
+    int32_t phase = (int32_t)(n++ % 16) - 8;
+
+    *result = 1650 + (phase * (int32_t)adc_amp_mv) / 8;
+    return 0;
+}
+#endif
+
+static void replay_thread(void *p1, void *p2, void *p3)
+{
+    struct replay_totals prev;
+    char *fields[16];
+    int64_t start_ms = k_uptime_get();
+    double t0 = 0.0, t = 0.0, hour_end = 0.0;
+    uint32_t rows = 0, skipped = 0, hour = 0;
+
+    totals_get(&prev, 0);
+    printk("REPLAY,hour,rows,samples,notif_live,notif_batch,radio_us_live,"
+           "radio_us_batch,ble_sent,host_cpu_us\n");
+
+    while (fgets(line, sizeof(line), file)) {
+        int n = split(line, fields, ARRAY_SIZE(fields));
+
+        if (cols[COL_TIME] >= n || parse_time(fields[cols[COL_TIME]], &t)) {
+            skipped++;
+            continue;
+        }
+
+        if (!rows) {
+            t0 = t;
+            hour_end = t0 + REPLAY_HOUR_S;
+        }
+        while (t >= hour_end) {
+            report(hour++, &prev, rows);
+            hour_end += REPLAY_HOUR_S;
+        }
+
+        /* Anchored to the first row, so pulses and slow rows never drift */
+        int64_t due_ms = start_ms + (int64_t)((t - t0) * MSEC_PER_SEC / replay_speedup);
+        int64_t wait_ms = due_ms - k_uptime_get();
+
+        if (wait_ms > 0) {
+            k_sleep(K_MSEC(wait_ms));
+        }
+
+        play_row(fields, n);
+        rows++;
+    }
+
+    report(hour, &prev, rows);
+    printk("REPLAY,done,%u,%u,%u\n", rows, skipped, (uint32_t)(t - t0));
+    fclose(file);
+
+    if (IS_ENABLED(CONFIG_APP_REPLAY_EXIT)) {
+        posix_exit(0);
+    }
+}
+
+int replay_start(void)
+{
+    int err;
+
+    if (!replay_file || !device_is_ready(dht_dev)) {
+        return -ENOENT;
+    }
+
+    file = fopen(replay_file, "r");
+    if (!file) {
+        return -ENOENT;
+    }
+    replay_speedup = MAX(replay_speedup, 1);
+
+    err = parse_header();
+    if (err) {
+        fclose(file);
+        return err;
+    }
+
+    gpio_emul_input_set(sound_gpio.port, sound_gpio.pin, sound_level(false));
+#ifdef CONFIG_SOUND_ADC
+    adc_emul_value_func_set(adc_dev, DT_IO_CHANNELS_INPUT(SOUND_ADC_NODE),
+                            replay_adc_signal, NULL);
+#endif
+
+    sample_ring_subscribe(&replay_consumer, NULL, replay_consumer_handler);
+
+    printk("Replaying %s at x%u\n", replay_file, replay_speedup);
+    k_thread_create(&replay_thread_data, replay_stack, K_THREAD_STACK_SIZEOF(replay_stack),
+                    replay_thread, NULL, NULL, NULL, REPLAY_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&replay_thread_data, "replay");
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/**
+ * @brief Starts playing the dataset given with --replay=<file> into the
+ *        emulated sensors and subscribes the cost counters to the
+ *        sample ring. Call after the sensors are initialised.
+ * @return 0 on success, -ENOENT when no dataset was given or it cannot
+ *         be opened, -EINVAL when its header lacks a date_time column.
+ */
+int replay_start(void);
+
+#endif
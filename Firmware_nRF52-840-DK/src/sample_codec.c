@@ -0,0 +1,178 @@
+/* sample_codec.c - Delta/zigzag/varint record codec for the flash log */
+
+#include <zephyr.h>
+#include <string.h>
+
+#include "sample_codec.h"
+#include "snapshot.h"
+
+static const uint8_t field_count[SAMPLE_KIND_COUNT] = {
+    [SAMPLE_GAS] = 1 + GAS_CHANNEL_COUNT,
+    [SAMPLE_ENV] = 2,
+    [SAMPLE_SOUND] = 4,
+    [SAMPLE_SOUND_LEVEL] = 3,
+};
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v)
+{
+    uint32_t out = 0;
+
+    for (int shift = 0; p < end && shift < 35; shift += 7) {
+        uint8_t b = *p++;
+
+        out |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = out;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void quantize(const struct sample *smp, int32_t *v)
+{
+    switch (smp->kind) {
+    case SAMPLE_GAS:
+        v[0] = smp->gas.valid;
+        v[1] = snapshot_centi_u16(smp->gas.co);
+        v[2] = snapshot_centi_u16(smp->gas.no2);
+        v[3] = snapshot_centi_u16(smp->gas.nh3);
+        v[4] = snapshot_centi_u16(smp->gas.ch4);
+        v[5] = snapshot_centi_u16(smp->gas.etoh);
+        break;
+    case SAMPLE_ENV:
+        v[0] = snapshot_centi_i16(smp->env.temp_c);
+        v[1] = snapshot_centi_u16(smp->env.hum_pct);
+        break;
+    case SAMPLE_SOUND:
+        v[0] = smp->sound.events;
+        v[1] = smp->sound.peak_rate_dhz;
+        v[2] = smp->sound.first_ms;
+        v[3] = smp->sound.last_ms;
+        break;
+    case SAMPLE_SOUND_LEVEL:
+        v[0] = smp->sound_level.rms;
+        v[1] = smp->sound_level.peak;
+        v[2] = smp->sound_level.dbfs_centi;
+        break;
+    }
+}
+
+static void dequantize(const int32_t *v, struct sample *smp)
+{
+    switch (smp->kind) {
+    case SAMPLE_GAS:
+        smp->gas.valid = v[0];
+        smp->gas.co = v[1] / 100.0f;
+        smp->gas.no2 = v[2] / 100.0f;
+        smp->gas.nh3 = v[3] / 100.0f;
+        smp->gas.ch4 = v[4] / 100.0f;
+        smp->gas.etoh = v[5] / 100.0f;
+        break;
+    case SAMPLE_ENV:
+        smp->env.temp_c = v[0] / 100.0f;
+        smp->env.hum_pct = v[1] / 100.0f;
+        break;
+    case SAMPLE_SOUND:
+        smp->sound.events = v[0];
+        smp->sound.peak_rate_dhz = v[1];
+        smp->sound.first_ms = v[2];
+        smp->sound.last_ms = v[3];
+        break;
+    case SAMPLE_SOUND_LEVEL:
+        smp->sound_level.rms = v[0];
+        smp->sound_level.peak = v[1];
+        smp->sound_level.dbfs_centi = v[2];
+        smp->sound_level.samples = 0;
+        break;
+    }
+}
+
+void sample_codec_reset(struct sample_codec *c, uint32_t base_ms)
+{
+    memset(c->prev, 0, sizeof(c->prev));
+    c->prev_ms = base_ms;
+}
+
+int sample_codec_encode(struct sample_codec *c, const struct sample *smp,
+                        uint8_t *buf, size_t size)
+{
+    int32_t v[SAMPLE_CODEC_MAX_FIELDS];
+    uint8_t *p = buf;
+
+    if (smp->kind >= SAMPLE_KIND_COUNT) {
+        return 0;
+    }
+    if (size < SAMPLE_CODEC_RECORD_MAX) {
+        return -ENOSPC;
+    }
+
+    quantize(smp, v);
+
+    *p++ = smp->kind;
+    p = put_varint(p, smp->timestamp_ms - c->prev_ms);
+    c->prev_ms = smp->timestamp_ms;
+
+    int32_t *prev = c->prev[smp->kind];
+
+    for (int i = 0; i < field_count[smp->kind]; i++) {
+        p = put_varint(p, zigzag(v[i] - prev[i]));
+        prev[i] = v[i];
+    }
+
+    return p - buf;
+}
+
+int sample_codec_decode(struct sample_codec *c, const uint8_t *buf, size_t len,
+                        struct sample *out)
+{
+    const uint8_t *p = buf, *end = buf + len;
+    int32_t v[SAMPLE_CODEC_MAX_FIELDS];
+    uint32_t u;
+
+    if (len < 2 || *p >= SAMPLE_KIND_COUNT) {
+        return -EINVAL;
+    }
+    out->kind = *p++;
+
+    p = get_varint(p, end, &u);
+    if (!p) {
+        return -EINVAL;
+    }
+    c->prev_ms += u;
+    out->timestamp_ms = c->prev_ms;
+
+    int32_t *prev = c->prev[out->kind];
+
+    for (int i = 0; i < field_count[out->kind]; i++) {
+        p = get_varint(p, end, &u);
+        if (!p) {
+            return -EINVAL;
+        }
+        prev[i] += unzigzag(u);
+        v[i] = prev[i];
+    }
+
+    dequantize(v, out);
+    return p - buf;
+}
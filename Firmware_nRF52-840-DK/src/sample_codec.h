@@ -0,0 +1,50 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#include "sample_ring.h"
+
+/* Streaming record codec for flash log blocks. Every channel is quantized
+ * to an integer (0.01 units for gas, temperature and humidity) and sent as
+ * the zigzag varint of its difference from the previous record of the
+ * same kind in the block. A record is:
+ *   u8 kind, varint ms since the previous record (or the block timestamp),
+ *   one zigzag varint per field:
+ *   GAS          valid, CO, NO2, NH3, CH4, C2H5OH
+ *   ENV          temp, humidity
+ *   SOUND        events, peak rate, first_ms, last_ms
+ *   SOUND_LEVEL  rms, peak, dBFS
+ * State restarts at every block so blocks decode on their own.
+ */
+#define SAMPLE_CODEC_MAX_FIELDS 6
+#define SAMPLE_CODEC_RECORD_MAX (1 + 5 + SAMPLE_CODEC_MAX_FIELDS * 5)
+
+struct sample_codec {
+    int32_t prev[SAMPLE_KIND_COUNT][SAMPLE_CODEC_MAX_FIELDS];
+    uint32_t prev_ms;
+};
+
+/**
+ * @brief Starts a block whose header carries base_ms.
+ */
+void sample_codec_reset(struct sample_codec *c, uint32_t base_ms);
+
+/**
+ * @brief Encodes one record after the previous one.
+ * @return bytes written, 0 for kinds the codec does not carry, -ENOSPC if
+ *         size is below SAMPLE_CODEC_RECORD_MAX.
+ */
+int sample_codec_encode(struct sample_codec *c, const struct sample *smp,
+                        uint8_t *buf, size_t size);
+
+/**
+ * @brief Decodes one record into out (kind, timestamp_ms and payload;
+ *        seq is left to the caller).
+ * @return bytes consumed, -EINVAL on a truncated or unknown record.
+ */
+int sample_codec_decode(struct sample_codec *c, const uint8_t *buf, size_t len,
+                        struct sample *out);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+/**
+ * @brief Subscribes the console logger to the sample ring.
+ */
+void sample_log_init(void);
+
+#endif
@@ -0,0 +1,161 @@
+/* sample_ring.c - Single-producer / multi-consumer ring of sample records.
+ *
+ * Each slot carries the sequence number of the record it holds. The
+ * producer clears it, writes the record and then stores the new sequence,
+ * so a reader that sees the same expected sequence before and after its
+ * copy knows the copy is not torn. Readers never block the producer; a
+ * reader that falls more than a ring behind loses the oldest records and
+ * counts them.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <sys/atomic.h>
+#include <sys/slist.h>
+#include <string.h>
+
+#include "sample_ring.h"
+
+#define RING_SIZE CONFIG_SAMPLE_RING_SIZE
+#define RING_MASK (RING_SIZE - 1)
+
+BUILD_ASSERT((RING_SIZE & RING_MASK) == 0, "CONFIG_SAMPLE_RING_SIZE must be a power of two");
+
+struct ring_slot {
+    atomic_t seq;   /* 0 while being written */
+    struct sample s;
+};
+
+static struct ring_slot slots[RING_SIZE];
+static atomic_t head;  /* seq of the last committed record */
+static sys_slist_t consumers = SYS_SLIST_STATIC_INIT(&consumers);
+#ifdef CONFIG_APP_BENCH
+static sample_ring_hook_t bench_hook;
+#endif
+
+uint32_t sample_ring_publish(struct sample *s)
+{
+    uint32_t seq = (uint32_t)atomic_get(&head) + 1;
+    struct ring_slot *slot = &slots[seq & RING_MASK];
+    struct sample_consumer *c;
+
+    s->seq = seq;
+    s->timestamp_ms = k_uptime_get_32();
+    s->stamp_cyc = k_cycle_get_32();
+
+    /* Atomics are full barriers: invalidate, write, then commit */
+    atomic_set(&slot->seq, 0);
+    slot->s = *s;
+#ifdef CONFIG_APP_BENCH
+    if (bench_hook) {
+        bench_hook(seq);
+    }
+#endif
+    atomic_set(&slot->seq, seq);
+    atomic_set(&head, seq);
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&consumers, c, node) {
+        if (c->queue) {
+            k_work_submit_to_queue(c->queue, &c->work);
+        } else {
+            k_work_submit(&c->work);
+        }
+    }
+    return seq;
+}
+
+/* Copy the record with the given seq; false if it was overwritten or torn */
+static bool slot_copy(uint32_t seq, struct sample *out)
+{
+    struct ring_slot *slot = &slots[seq & RING_MASK];
+
+    if ((uint32_t)atomic_get(&slot->seq) != seq) {
+        return false;
+    }
+    *out = slot->s;
+    return (uint32_t)atomic_get(&slot->seq) == seq;
+}
+
+void sample_reader_init(struct sample_reader *r)
+{
+    r->next = (uint32_t)atomic_get(&head) + 1;
+    r->lost = 0;
+}
+
+int sample_ring_read(struct sample_reader *r, struct sample *out)
+{
+    for (;;) {
+        uint32_t last = (uint32_t)atomic_get(&head);
+
+        if ((int32_t)(last - r->next) < 0) {
+            return -EAGAIN;
+        }
+
+        /* Lapped by the producer: jump to the oldest record still present */
+        if (last - r->next >= RING_SIZE) {
+            uint32_t oldest = last - RING_SIZE + 1;
+
+            r->lost += oldest - r->next;
+            r->next = oldest;
+        }
+
+        if (slot_copy(r->next, out)) {
+            r->next++;
+            return 0;
+        }
+
+        /* Overwritten during the copy */
+        r->lost++;
+        r->next++;
+    }
+}
+
+int sample_ring_latest(enum sample_kind kind, struct sample *out)
+{
+    uint32_t last = (uint32_t)atomic_get(&head);
+
+    for (uint32_t n = 0; n < RING_SIZE && n < last; n++) {
+        if (slot_copy(last - n, out) && out->kind == kind) {
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+void sample_ring_subscribe(struct sample_consumer *c, struct k_work_q *queue,
+                           k_work_handler_t handler)
+{
+    sample_reader_init(&c->reader);
+    k_work_init(&c->work, handler);
+    c->queue = queue;
+    sys_slist_append(&consumers, &c->node);
+}
+
+uint32_t sample_ring_published(void)
+{
+    return (uint32_t)atomic_get(&head);
+}
+
+void sample_ring_get_stats(struct sample_ring_stats *st)
+{
+    uint32_t last = (uint32_t)atomic_get(&head);
+    struct sample_consumer *c;
+
+    memset(st, 0, sizeof(*st));
+    st->published = last;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&consumers, c, node) {
+        uint32_t lag = last + 1 - c->reader.next;
+
+        st->max_lag = MAX(st->max_lag, MIN(lag, RING_SIZE));
+        st->lost += c->reader.lost;
+        st->consumers++;
+    }
+}
+
+#ifdef CONFIG_APP_BENCH
+void sample_ring_bench_set_hook(sample_ring_hook_t hook)
+{
+    bench_hook = hook;
+}
+#endif
@@ -0,0 +1,118 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <zephyr/types.h>
+#include <kernel.h>
+#include <sys/slist.h>
+#include "gas_sensor.h"
+#include "sound_window.h"
+#include "sound_level.h"
+
+enum sample_kind {
+    SAMPLE_GAS,
+    SAMPLE_ENV,
+    SAMPLE_SOUND,
+    SAMPLE_SOUND_LEVEL,
+    SAMPLE_KIND_COUNT
+};
+
+/* Fixed-size record handed from acquisition to the transports */
+struct sample {
+    uint32_t seq;           /* 1-based, increments on every publish */
+    uint32_t timestamp_ms;  /* k_uptime_get_32() at acquisition */
+    uint32_t stamp_cyc;     /* k_cycle_get_32() at acquisition, for latency histograms */
+    uint8_t kind;           /* enum sample_kind */
+    union {
+        struct gas_data gas;
+        struct {
+            float temp_c;
+            float hum_pct;
+        } env;
+        struct sound_window sound;
+        struct sound_level sound_level;
+    };
+};
+
+/* Read cursor of one consumer; each consumer owns its own */
+struct sample_reader {
+    uint32_t next;  /* seq of the next record to read */
+    uint32_t lost;  /* records overwritten before this reader got to them */
+};
+
+/* Consumer woken through a work item after every publish */
+struct sample_consumer {
+    struct sample_reader reader;
+    struct k_work work;
+    struct k_work_q *queue;
+    sys_snode_t node;
+};
+
+/* Depth of the ring as seen by its consumers */
+struct sample_ring_stats {
+    uint32_t published;  /* records since boot */
+    uint32_t max_lag;    /* records the slowest consumer has not read yet */
+    uint32_t lost;       /* records overwritten before a consumer read them, all consumers */
+    uint16_t consumers;
+};
+
+/**
+ * @brief Stamps and publishes a record, overwriting the oldest one when full.
+ *
+ * Single producer: the application only calls it from the system work
+ * queue, where the sensor scheduler runs. seq, timestamp_ms and
+ * stamp_cyc are filled in here.
+ * @return the sequence number assigned to the record.
+ */
+uint32_t sample_ring_publish(struct sample *s);
+
+/**
+ * @brief Positions a reader at the next record to be published.
+ */
+void sample_reader_init(struct sample_reader *r);
+
+/**
+ * @brief Copies the next record for this reader without taking a lock.
+ *
+ * Records the producer overwrote first are skipped and added to r->lost.
+ * @return 0 when a record was copied, -EAGAIN when the reader is caught up.
+ */
+int sample_ring_read(struct sample_reader *r, struct sample *out);
+
+/**
+ * @brief Copies the most recent record of the given kind.
+ * @return 0 on success, -ENOENT when none is left in the ring.
+ */
+int sample_ring_latest(enum sample_kind kind, struct sample *out);
+
+/**
+ * @brief Registers a consumer whose handler is submitted to queue
+ *        (system work queue when NULL) after every publish. The handler
+ *        drains c->reader with sample_ring_read(). Subscribe before
+ *        sampling starts; the consumer list is not locked.
+ */
+void sample_ring_subscribe(struct sample_consumer *c, struct k_work_q *queue,
+                           k_work_handler_t handler);
+
+/**
+ * @brief Number of records published since boot.
+ */
+uint32_t sample_ring_published(void);
+
+/**
+ * @brief Fills in the ring statistics. The consumer cursors are read
+ *        without locks, so the figures may be one record off.
+ */
+void sample_ring_get_stats(struct sample_ring_stats *st);
+
+#ifdef CONFIG_APP_BENCH
+typedef void (*sample_ring_hook_t)(uint32_t seq);
+
+/**
+ * @brief Sets a function called inside sample_ring_publish() after the
+ *        slot is written and before its seq is committed, so a test can
+ *        read while a record is half published. NULL removes it.
+ */
+void sample_ring_bench_set_hook(sample_ring_hook_t hook);
+#endif
+
+#endif
@@ -0,0 +1,335 @@
+/* sample_store.c - Append-only flash log of the sample ring
+ *
+ * Records are packed into blocks in RAM and appended to a flash circular
+ * buffer (FCB) on the sample-log partition. The FCB writes sectors in
+ * order and erases the oldest one when the log is full, so every sector
+ * sees the same number of erase cycles.
+ */
+
+#include <zephyr.h>
+#include <storage/flash_map.h>
+#include <sys/byteorder.h>
+#include <logging/log.h>
+#include <string.h>
+
+#include "sample_store.h"
+#include "sample_ring.h"
+#include "sample_codec.h"
+
+LOG_MODULE_REGISTER(sample_store, LOG_LEVEL_INF);
+
+#define STORE_MAGIC       0x536f6d4e  /* "SomN" */
+#define STORE_FCB_VERSION 1
+#define STORE_AREA_ID     FLASH_AREA_ID(sample_log)
+
+/* Blocks this build can hand to readers */
+#define BLOCK_VERSION_OK(v) ((v) >= 1 && (v) <= SAMPLE_STORE_BLOCK_VERSION)
+
+static struct flash_sector store_sectors[CONFIG_SAMPLE_STORE_MAX_SECTORS];
+static struct fcb store_fcb;
+static struct sample_consumer store_consumer;
+
+static struct {
+    uint8_t buf[SAMPLE_STORE_BLOCK_MAX];
+    uint16_t len;
+    uint8_t count;
+    struct sample_codec codec;
+} block;
+
+/* Log range, read from other threads through sample_store_range() */
+static struct k_spinlock range_lock;
+static uint32_t next_seq = 1;
+static uint32_t first_seq = 1;  /* oldest record in flash */
+static uint16_t boot_count;
+static uint32_t rotations;
+static bool store_ready;
+
+static int read_header(const struct fcb_entry *loc, uint8_t *hdr)
+{
+    if (loc->fe_data_len < SAMPLE_STORE_BLOCK_HDR_LEN) {
+        return -EINVAL;
+    }
+    return flash_area_read(store_fcb.fap, FCB_ENTRY_FA_DATA_OFF(*loc), hdr,
+                           SAMPLE_STORE_BLOCK_HDR_LEN);
+}
+
+static void update_first_seq(void)
+{
+    struct fcb_entry loc = { 0 };
+    uint8_t hdr[SAMPLE_STORE_BLOCK_HDR_LEN];
+    uint32_t first = next_seq - block.count;
+
+    while (fcb_getnext(&store_fcb, &loc) == 0) {
+        if (read_header(&loc, hdr) == 0 && BLOCK_VERSION_OK(hdr[0])) {
+            first = sys_get_le32(&hdr[4]);
+            break;
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&range_lock);
+
+    first_seq = first;
+    k_spin_unlock(&range_lock, key);
+}
+
+static int append_block(const uint8_t *data, uint16_t len)
+{
+    struct fcb_entry loc;
+    int err;
+
+    err = fcb_append(&store_fcb, len, &loc);
+    if (err == -ENOSPC) {
+        /* Full: drop the oldest sector and retry once */
+        err = fcb_rotate(&store_fcb);
+        if (err) {
+            return err;
+        }
+        rotations++;
+        update_first_seq();
+        err = fcb_append(&store_fcb, len, &loc);
+    }
+    if (err) {
+        return err;
+    }
+
+    err = flash_area_write(store_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), data, len);
+    if (err) {
+        return err;
+    }
+    return fcb_append_finish(&store_fcb, &loc);
+}
+
+int sample_store_flush(void)
+{
+    int err;
+
+    if (!store_ready || block.count == 0) {
+        return 0;
+    }
+
+    block.buf[1] = block.count;
+    err = append_block(block.buf, block.len);
+    if (err) {
+        LOG_ERR("Block append failed (err %d), %u records lost", err, block.count);
+    }
+    block.count = 0;
+    return err;
+}
+
+void sample_store_append(const struct sample *smp)
+{
+    if (!store_ready) {
+        return;
+    }
+
+    if (block.count && (block.count == UINT8_MAX ||
+                        block.len + SAMPLE_CODEC_RECORD_MAX > sizeof(block.buf))) {
+        sample_store_flush();
+    }
+
+    if (block.count == 0) {
+        block.buf[0] = SAMPLE_STORE_BLOCK_VERSION;
+        sys_put_le16(boot_count, &block.buf[2]);
+        sys_put_le32(next_seq, &block.buf[4]);
+        sys_put_le32(smp->timestamp_ms, &block.buf[8]);
+        sample_codec_reset(&block.codec, smp->timestamp_ms);
+        block.len = SAMPLE_STORE_BLOCK_HDR_LEN;
+    }
+
+    int n = sample_codec_encode(&block.codec, smp, &block.buf[block.len],
+                                sizeof(block.buf) - block.len);
+
+    if (n > 0) {
+        k_spinlock_key_t key = k_spin_lock(&range_lock);
+
+        block.len += n;
+        block.count++;
+        next_seq++;
+        k_spin_unlock(&range_lock, key);
+    }
+}
+
+static void store_consumer_handler(struct k_work *work)
+{
+    struct sample smp;
+
+    while (sample_ring_read(&store_consumer.reader, &smp) == 0) {
+        sample_store_append(&smp);
+    }
+}
+
+/* Walks the log once at boot to continue its sequence numbers */
+static void recover_tail(void)
+{
+    struct fcb_entry loc = { 0 };
+    uint8_t hdr[SAMPLE_STORE_BLOCK_HDR_LEN];
+    uint32_t blocks = 0;
+
+    while (fcb_getnext(&store_fcb, &loc) == 0) {
+        if (read_header(&loc, hdr) || !BLOCK_VERSION_OK(hdr[0])) {
+            continue;
+        }
+        next_seq = sys_get_le32(&hdr[4]) + hdr[1];
+        boot_count = sys_get_le16(&hdr[2]) + 1;
+        blocks++;
+    }
+
+    LOG_INF("%u blocks in flash, next seq %u, boot %u", blocks, next_seq, boot_count);
+}
+
+/* Mounts the log on a partition, without the ring subscription */
+static int store_mount(uint8_t area_id)
+{
+    uint32_t cnt = ARRAY_SIZE(store_sectors);
+    int err;
+
+    err = flash_area_get_sectors(area_id, &cnt, store_sectors);
+    if (err) {
+        return err;
+    }
+    if (cnt > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    store_fcb.f_magic = STORE_MAGIC;
+    store_fcb.f_version = STORE_FCB_VERSION;
+    store_fcb.f_sector_cnt = cnt;
+    store_fcb.f_scratch_cnt = 0;
+    store_fcb.f_sectors = store_sectors;
+
+    err = fcb_init(area_id, &store_fcb);
+    if (err) {
+        /* Unrecognised contents: start a fresh log */
+        LOG_WRN("Log unreadable (err %d), erasing", err);
+        const struct flash_area *fa;
+
+        err = flash_area_open(area_id, &fa);
+        if (err) {
+            return err;
+        }
+        err = flash_area_erase(fa, 0, fa->fa_size);
+        flash_area_close(fa);
+        if (err) {
+            return err;
+        }
+        err = fcb_init(area_id, &store_fcb);
+        if (err) {
+            return err;
+        }
+    }
+
+    recover_tail();
+    update_first_seq();
+    store_ready = true;
+    return 0;
+}
+
+int sample_store_init(void)
+{
+    int err;
+
+    if (store_ready) {
+        return 0;
+    }
+
+    err = store_mount(STORE_AREA_ID);
+    if (err) {
+        return err;
+    }
+
+    sample_ring_subscribe(&store_consumer, NULL, store_consumer_handler);
+    return 0;
+}
+
+#ifdef CONFIG_APP_BENCH
+int sample_store_bench_open(uint8_t area_id)
+{
+    const struct flash_area *fa;
+    int err;
+
+    if (store_ready) {
+        return -EBUSY;
+    }
+
+    err = flash_area_open(area_id, &fa);
+    if (err) {
+        return err;
+    }
+    err = flash_area_erase(fa, 0, fa->fa_size);
+    flash_area_close(fa);
+    if (err) {
+        return err;
+    }
+    return store_mount(area_id);
+}
+
+void sample_store_bench_close(void)
+{
+    store_ready = false;
+    memset(&store_fcb, 0, sizeof(store_fcb));
+    block.count = 0;
+    next_seq = 1;
+    first_seq = 1;
+    boot_count = 0;
+    rotations = 0;
+}
+#endif /* CONFIG_APP_BENCH */
+
+void sample_store_range(uint32_t *first, uint32_t *next)
+{
+    k_spinlock_key_t key = k_spin_lock(&range_lock);
+
+    *first = first_seq;
+    *next = next_seq;
+    k_spin_unlock(&range_lock, key);
+}
+
+void sample_store_cursor_init(struct sample_store_cursor *cur, uint32_t from_seq)
+{
+    cur->loc.fe_sector = NULL;
+    cur->loc.fe_elem_off = 0;
+    cur->from_seq = from_seq;
+    cur->rotations = rotations;
+}
+
+int sample_store_next(struct sample_store_cursor *cur, uint8_t *buf, size_t size)
+{
+    uint8_t hdr[SAMPLE_STORE_BLOCK_HDR_LEN];
+    int err;
+
+    if (!store_ready) {
+        return -ENODEV;
+    }
+
+    if (cur->rotations != rotations) {
+        /* The sector under the cursor may be gone; from_seq skips what
+         * was already returned.
+         */
+        sample_store_cursor_init(cur, cur->from_seq);
+    }
+
+    while (fcb_getnext(&store_fcb, &cur->loc) == 0) {
+        if (read_header(&cur->loc, hdr) || !BLOCK_VERSION_OK(hdr[0])) {
+            continue;
+        }
+
+        uint32_t end = sys_get_le32(&hdr[4]) + hdr[1];
+
+        if (end <= cur->from_seq) {
+            continue;
+        }
+        if (cur->loc.fe_data_len > size) {
+            return -ENOMEM;
+        }
+
+        err = flash_area_read(store_fcb.fap, FCB_ENTRY_FA_DATA_OFF(cur->loc), buf,
+                              cur->loc.fe_data_len);
+        if (err) {
+            return err;
+        }
+        cur->from_seq = end;
+        return cur->loc.fe_data_len;
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef SAMPLE_STORE_H
+#define SAMPLE_STORE_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <fs/fcb.h>
+
+struct sample;
+
+/* Flash log block, little endian. Blocks are the unit written to flash
+ * and streamed over BLE, so one fits a single notification.
+ *  0  u8   SAMPLE_STORE_BLOCK_VERSION
+ *  1  u8   record count
+ *  2  u16  boot count of the device when the block was written
+ *  4  u32  log sequence number of the first record
+ *  8  u32  timestamp_ms (since boot) of the first record
+ * 12  records, log sequence numbers consecutive from the header, in
+ *     the sample_codec format (version 2). Version 1 blocks carried
+ *     fixed-width records and are still returned by the cursor.
+ */
+#define SAMPLE_STORE_BLOCK_VERSION 2
+#define SAMPLE_STORE_BLOCK_HDR_LEN 12
+#define SAMPLE_STORE_BLOCK_MAX     240
+
+/* Incremental reader over the blocks in flash, oldest first */
+struct sample_store_cursor {
+    struct fcb_entry loc;
+    uint32_t from_seq;   /* blocks entirely below this are skipped */
+    uint32_t rotations;  /* store rotations seen; a change restarts the walk */
+};
+
+/**
+ * @brief Mounts the log partition, recovers the next log sequence number
+ *        and subscribes to the sample ring. Later calls do nothing.
+ * @return 0 on success, negative error code otherwise.
+ */
+int sample_store_init(void);
+
+#ifdef CONFIG_APP_BENCH
+/**
+ * @brief Erases a scratch partition and mounts the store on it, without
+ *        the ring subscription, so a benchmark can fill and replay a log
+ *        without touching the real one. Call before sample_store_init().
+ * @return 0 on success, -EBUSY once the real log is mounted, negative
+ *         error code otherwise.
+ */
+int sample_store_bench_open(uint8_t area_id);
+
+/**
+ * @brief Unmounts the scratch log; sample_store_init() then mounts the
+ *        real one as usual.
+ */
+void sample_store_bench_close(void);
+#endif
+
+/**
+ * @brief Adds one record to the block being filled, writing the block to
+ *        flash when it is full. Called by the store's ring consumer.
+ */
+void sample_store_append(const struct sample *smp);
+
+/**
+ * @brief Writes the block being filled to flash, even if not full.
+ *
+ * Records in RAM are lost on reset; readers call this first so the
+ * backlog they see is complete.
+ * @return 0 on success or if there was nothing to write.
+ */
+int sample_store_flush(void);
+
+/**
+ * @brief Log sequence numbers of the oldest record in flash and of the
+ *        next record to be stored.
+ */
+void sample_store_range(uint32_t *first, uint32_t *next);
+
+void sample_store_cursor_init(struct sample_store_cursor *cur, uint32_t from_seq);
+
+/**
+ * @brief Copies the next block holding records at or after cur->from_seq.
+ *
+ * Call from the system work queue, where blocks are appended, so the
+ * cursor never sees a half-rotated log.
+ * @return block length, 0 at the end of the log, negative error code
+ *         otherwise.
+ */
+int sample_store_next(struct sample_store_cursor *cur, uint8_t *buf, size_t size);
+
+#endif
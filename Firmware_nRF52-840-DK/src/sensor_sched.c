@@ -0,0 +1,148 @@
+/* sensor_sched.c - Single delayable work item driving every periodic sensor.
+ * Replaces the per-sensor sleep loops: each tick runs all due tasks and
+ * re-arms itself for the earliest absolute deadline, so read durations do
+ * not add up into drift.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <sys/slist.h>
+#include <sys/util.h>
+#include <logging/log.h>
+
+#include "sensor_sched.h"
+#include "histo.h"
+
+LOG_MODULE_REGISTER(sensor_sched, LOG_LEVEL_INF);
+
+static sys_slist_t tasks = SYS_SLIST_STATIC_INIT(&tasks);
+static struct k_spinlock lock;
+static struct k_work_delayable tick_work;
+static int64_t epoch_ms;
+static bool started;
+
+/* First grid slot of the task strictly after now */
+static int64_t next_slot_after(const struct sched_task *task, int64_t now)
+{
+    int64_t first = epoch_ms + task->phase_ms;
+
+    if (now < first) {
+        return first;
+    }
+    return first + ((now - first) / task->period_ms + 1) * task->period_ms;
+}
+
+static void rearm(void)
+{
+    int64_t next = INT64_MAX;
+    struct sched_task *task;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+        next = MIN(next, task->next_ms);
+    }
+    k_spin_unlock(&lock, key);
+
+    if (next != INT64_MAX) {
+        k_work_reschedule(&tick_work, K_TIMEOUT_ABS_MS(next));
+    }
+}
+
+/* Deviation from the nominal period in cycles, so a stalled tick shows up
+ * even when the grid absorbs it. The nominal period is the spacing of the
+ * two deadlines as they were armed, so a sched_set_period() in between
+ * is not counted as jitter. Periods beyond a cycle counter wrap (67 s at
+ * 64 MHz) read wrong.
+ */
+static void record_period(struct sched_task *task, int64_t due_ms)
+{
+    uint32_t now = k_cycle_get_32();
+
+    if (task->jitter && task->runs) {
+        uint32_t actual = now - task->last_cyc;
+        uint32_t nominal = k_ms_to_cyc_near32((uint32_t)(due_ms - task->last_due_ms));
+
+        histo_add(task->jitter, actual > nominal ? actual - nominal : nominal - actual);
+    }
+    task->last_cyc = now;
+    task->last_due_ms = due_ms;
+}
+
+static void tick_handler(struct k_work *work)
+{
+    int64_t now = k_uptime_get();
+    struct sched_task *task;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        int64_t due_ms = task->next_ms;
+        bool due = due_ms <= now;
+
+        if (due) {
+            int64_t next = next_slot_after(task, now);
+
+            /* Slots skipped because a previous tick overran */
+            task->missed += (next - task->next_ms) / task->period_ms - 1;
+            task->next_ms = next;
+        }
+        k_spin_unlock(&lock, key);
+
+        if (due) {
+            record_period(task, due_ms);
+            task->fn(task);
+            task->runs++;
+        }
+    }
+
+    rearm();
+}
+
+int sched_add(struct sched_task *task)
+{
+    if (task->period_ms == 0 || task->fn == NULL) {
+        return -EINVAL;
+    }
+    if (started) {
+        return -EBUSY;
+    }
+
+    task->runs = 0;
+    task->missed = 0;
+    sys_slist_append(&tasks, &task->node);
+    return 0;
+}
+
+int sched_set_period(struct sched_task *task, uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    task->period_ms = period_ms;
+    if (started) {
+        task->next_ms = next_slot_after(task, k_uptime_get());
+    }
+    k_spin_unlock(&lock, key);
+
+    if (started) {
+        rearm();
+    }
+    LOG_INF("%s period %u ms", task->name, period_ms);
+    return 0;
+}
+
+void sched_start(void)
+{
+    struct sched_task *task;
+
+    k_work_init_delayable(&tick_work, tick_handler);
+    epoch_ms = k_uptime_get();
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+        task->next_ms = epoch_ms + task->phase_ms;
+    }
+    started = true;
+    rearm();
+}
@@ -0,0 +1,60 @@
+#ifndef SENSOR_SCHED_H
+#define SENSOR_SCHED_H
+
+#include <zephyr/types.h>
+#include <sys/slist.h>
+
+struct sched_task;
+struct histo;
+
+/**
+ * @brief Sampling function, runs on the system work queue.
+ */
+typedef void (*sched_fn_t)(struct sched_task *task);
+
+/**
+ * @brief A periodic sampling job.
+ *
+ * Deadlines sit on a grid anchored at the scheduler epoch:
+ * epoch + phase_ms + k * period_ms. They never accumulate the time spent
+ * sampling, and tasks with harmonic periods run in the same tick.
+ */
+struct sched_task {
+    const char *name;
+    sched_fn_t fn;
+    uint32_t period_ms;
+    uint32_t phase_ms;
+    /* Optional, gets |actual - nominal| period of every run (histo.h) */
+    struct histo *jitter;
+
+    /* Private, managed by the scheduler */
+    int64_t next_ms;
+    uint32_t runs;
+    uint32_t missed;
+    uint32_t last_cyc;  /* cycle counter at the previous run */
+    int64_t last_due_ms;  /* deadline the previous run was armed for */
+    sys_snode_t node;
+};
+
+#define SCHED_TASK_INITIALIZER(_name, _fn, _period_ms, _phase_ms) \
+    { .name = (_name), .fn = (_fn), .period_ms = (_period_ms), .phase_ms = (_phase_ms) }
+
+/**
+ * @brief Registers a task. Must be called before sched_start().
+ * @return 0 on success, -EINVAL for a zero period, -EBUSY once started.
+ */
+int sched_add(struct sched_task *task);
+
+/**
+ * @brief Changes the period of a task at runtime. The next deadline is
+ *        re-aligned to the task's grid so phase relations are kept.
+ * @return 0 on success, -EINVAL for a zero period.
+ */
+int sched_set_period(struct sched_task *task, uint32_t period_ms);
+
+/**
+ * @brief Sets the epoch to now and schedules the first tick.
+ */
+void sched_start(void);
+
+#endif
@@ -0,0 +1,107 @@
+/* snapshot.c - Fixed-point combined snapshot of all channels */
+
+#include <zephyr.h>
+#include <sys/byteorder.h>
+#include <sys/util.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+uint16_t snapshot_centi_u16(float v)
+{
+    float c = v * 100.0f + 0.5f;
+
+    if (c <= 0.0f) {
+        return 0;
+    }
+    return c >= UINT16_MAX ? UINT16_MAX : (uint16_t)c;
+}
+
+int16_t snapshot_centi_i16(float v)
+{
+    float c = v * 100.0f;
+
+    c += c < 0.0f ? -0.5f : 0.5f;
+    return (int16_t)CLAMP(c, INT16_MIN, INT16_MAX);
+}
+
+bool snapshot_update(struct snapshot_state *st, const struct sample *smp)
+{
+    switch (smp->kind) {
+    case SAMPLE_GAS: {
+        const float ppm[GAS_CHANNEL_COUNT] = {
+            smp->gas.co, smp->gas.no2, smp->gas.nh3, smp->gas.ch4, smp->gas.etoh,
+        };
+
+        for (int ch = 0; ch < GAS_CHANNEL_COUNT; ch++) {
+            st->gas_centi[ch] = snapshot_centi_u16(ppm[ch]);
+        }
+        st->valid = (st->valid & ~GAS_VALID_ALL) | (smp->gas.valid & GAS_VALID_ALL);
+        break;
+    }
+    case SAMPLE_ENV:
+        st->temp_centi = snapshot_centi_i16(smp->env.temp_c);
+        st->hum_centi = snapshot_centi_u16(smp->env.hum_pct);
+        st->valid |= SNAPSHOT_VALID_TEMP | SNAPSHOT_VALID_HUM;
+        break;
+    case SAMPLE_SOUND:
+        st->sound_events = smp->sound.events;
+        st->valid |= SNAPSHOT_VALID_SOUND;
+        break;
+    default:
+        return false;
+    }
+
+    st->timestamp_ms = smp->timestamp_ms;
+    return true;
+}
+
+void snapshot_from_ring(struct snapshot_state *st)
+{
+    static const enum sample_kind kinds[] = { SAMPLE_GAS, SAMPLE_ENV, SAMPLE_SOUND };
+    uint32_t newest = 0;
+    struct sample smp;
+
+    for (int i = 0; i < ARRAY_SIZE(kinds); i++) {
+        if (sample_ring_latest(kinds[i], &smp) == 0) {
+            snapshot_update(st, &smp);
+            newest = MAX(newest, smp.timestamp_ms);
+        }
+    }
+    st->timestamp_ms = newest;
+}
+
+uint16_t snapshot_encode(struct snapshot_state *st, uint8_t *buf)
+{
+    buf[0] = SNAPSHOT_VERSION;
+    buf[1] = st->valid;
+    sys_put_le16(st->seq++, &buf[2]);
+    sys_put_le32(st->timestamp_ms, &buf[4]);
+    for (int ch = 0; ch < GAS_CHANNEL_COUNT; ch++) {
+        sys_put_le16(st->gas_centi[ch], &buf[8 + ch * 2]);
+    }
+    sys_put_le16((uint16_t)st->temp_centi, &buf[18]);
+    sys_put_le16(st->hum_centi, &buf[20]);
+    sys_put_le16(st->sound_events, &buf[22]);
+    return SNAPSHOT_LEN;
+}
+
+uint8_t snapshot_batch_add(struct snapshot_batch *b, const uint8_t *record)
+{
+    __ASSERT_NO_MSG(b->count < SNAPSHOT_BATCH_MAX);
+    memcpy(&b->buf[SNAPSHOT_BATCH_LEN(b->count)], record, SNAPSHOT_LEN);
+    return ++b->count;
+}
+
+uint16_t snapshot_batch_take(struct snapshot_batch *b)
+{
+    uint8_t n = b->count;
+
+    if (n == 0) {
+        return 0;
+    }
+    b->buf[0] = SNAPSHOT_BATCH_TAG;
+    b->buf[1] = n;
+    b->count = 0;
+    return SNAPSHOT_BATCH_LEN(n);
+}
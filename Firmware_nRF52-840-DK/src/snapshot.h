@@ -0,0 +1,85 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <zephyr/types.h>
+#include "sample_ring.h"
+
+/* Combined snapshot payload, little endian:
+ *  0  u8   version (SNAPSHOT_VERSION)
+ *  1  u8   valid bitmask (SNAPSHOT_VALID_*)
+ *  2  u16  sequence number
+ *  4  u32  device timestamp, ms since boot, of the newest reading
+ *  8  u16  CO, NO2, NH3, CH4, C2H5OH in 0.01 ppm (5 x u16)
+ * 18  i16  temperature in 0.01 C
+ * 20  u16  humidity in 0.01 %
+ * 22  u16  sound events in the last window
+ */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_LEN     24
+
+/* Bits 0..4 follow enum gas_channel */
+#define SNAPSHOT_VALID_TEMP  BIT(5)
+#define SNAPSHOT_VALID_HUM   BIT(6)
+#define SNAPSHOT_VALID_SOUND BIT(7)
+
+/* Batch frame: u8 SNAPSHOT_BATCH_TAG, u8 record count, then that many
+ * SNAPSHOT_LEN records. Ten records fill a 247-byte ATT MTU.
+ */
+#define SNAPSHOT_BATCH_TAG     0x81
+#define SNAPSHOT_BATCH_HDR_LEN 2
+#define SNAPSHOT_BATCH_MAX     10
+#define SNAPSHOT_BATCH_LEN(n)  (SNAPSHOT_BATCH_HDR_LEN + (n) * SNAPSHOT_LEN)
+
+struct snapshot_batch {
+    uint8_t count;
+    uint8_t buf[SNAPSHOT_BATCH_LEN(SNAPSHOT_BATCH_MAX)];
+};
+
+/* Latest value of every channel, folded from ring records */
+struct snapshot_state {
+    uint16_t seq;
+    uint8_t valid;
+    uint32_t timestamp_ms;
+    uint16_t gas_centi[GAS_CHANNEL_COUNT];
+    int16_t temp_centi;
+    uint16_t hum_centi;
+    uint16_t sound_events;
+};
+
+/* Float to 0.01 fixed point, rounded and clamped to the field range */
+uint16_t snapshot_centi_u16(float v);
+int16_t snapshot_centi_i16(float v);
+
+/**
+ * @brief Folds a ring record into the snapshot.
+ * @return true if the record changed a field carried by the snapshot.
+ */
+bool snapshot_update(struct snapshot_state *st, const struct sample *smp);
+
+/**
+ * @brief Rebuilds a snapshot from the newest ring record of each kind,
+ *        without locks; used where the running state cannot be shared.
+ */
+void snapshot_from_ring(struct snapshot_state *st);
+
+/**
+ * @brief Encodes the snapshot and advances its sequence number.
+ * @param buf At least SNAPSHOT_LEN bytes
+ * @return number of bytes written (SNAPSHOT_LEN).
+ */
+uint16_t snapshot_encode(struct snapshot_state *st, uint8_t *buf);
+
+/**
+ * @brief Appends an encoded snapshot (SNAPSHOT_LEN bytes) to a batch.
+ * @return records in the batch after the append; flush once it returns
+ *         SNAPSHOT_BATCH_MAX.
+ */
+uint8_t snapshot_batch_add(struct snapshot_batch *b, const uint8_t *record);
+
+/**
+ * @brief Finalises the batch header and empties the batch.
+ * @return frame length to send, 0 if the batch held no records.
+ */
+uint16_t snapshot_batch_take(struct snapshot_batch *b);
+
+#endif
@@ -0,0 +1,146 @@
+/* sound_adc.c - Continuous sampling of the sound module's analog output.
+ * Two sample buffers alternate: when the ADC finishes one, a work item
+ * restarts it on the other buffer and then reduces the finished block,
+ * so conversion and processing overlap.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <device.h>
+#include <devicetree.h>
+#include <drivers/adc.h>
+#include <logging/log.h>
+#ifdef CONFIG_ADC_NRFX_SAADC
+#include <hal/nrf_saadc.h>
+#endif
+#ifdef CONFIG_ADC_EMUL
+#include <drivers/adc/adc_emul.h>
+#endif
+
+#include "sound_adc.h"
+
+LOG_MODULE_REGISTER(sound_adc, LOG_LEVEL_INF);
+
+#define SOUND_ADC_NODE DT_PATH(zephyr_user)
+#define SOUND_ADC_CHANNEL DT_IO_CHANNELS_INPUT(SOUND_ADC_NODE)
+#define SOUND_ADC_RESOLUTION 12
+#define SOUND_ADC_FULL_SCALE ((1 << (SOUND_ADC_RESOLUTION - 1)) - 1)
+
+#define BLOCK_SAMPLES CONFIG_SOUND_ADC_BLOCK_SAMPLES
+
+static const struct device *adc_dev = DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(SOUND_ADC_NODE));
+
+static const struct adc_channel_cfg channel_cfg = {
+    .gain = ADC_GAIN_1_6,
+    .reference = ADC_REF_INTERNAL,
+    .acquisition_time = ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, 10),
+    .channel_id = SOUND_ADC_CHANNEL,
+#ifdef CONFIG_ADC_NRFX_SAADC
+    .input_positive = NRF_SAADC_INPUT_AIN0 + SOUND_ADC_CHANNEL,
+#endif
+};
+
+static int16_t buffers[2][BLOCK_SAMPLES];
+static uint8_t active;
+static struct k_poll_signal adc_signal;
+static struct sound_level_acc acc;
+static uint32_t window_start;
+static sound_level_cb_t level_cb;
+
+static void adc_work_fn(struct k_work *work);
+static K_WORK_DEFINE(adc_work, adc_work_fn);
+
+/* ISR context: only flag the end of a block */
+static enum adc_action sampling_cb(const struct device *dev, const struct adc_sequence *seq,
+                                   uint16_t sampling_index)
+{
+    if (sampling_index == seq->options->extra_samplings) {
+        k_work_submit(&adc_work);
+    }
+    return ADC_ACTION_CONTINUE;
+}
+
+static const struct adc_sequence_options seq_opts = {
+    .interval_us = USEC_PER_SEC / CONFIG_SOUND_ADC_RATE_HZ,
+    .callback = sampling_cb,
+    .extra_samplings = BLOCK_SAMPLES - 1,
+};
+
+static int start_block(int16_t *buf)
+{
+    struct adc_sequence seq = {
+        .options = &seq_opts,
+        .channels = BIT(SOUND_ADC_CHANNEL),
+        .buffer = buf,
+        .buffer_size = BLOCK_SAMPLES * sizeof(int16_t),
+        .resolution = SOUND_ADC_RESOLUTION,
+    };
+
+    return adc_read_async(adc_dev, &seq, &adc_signal);
+}
+
+static void adc_work_fn(struct k_work *work)
+{
+    const int16_t *done = buffers[active];
+    int err;
+
+    active ^= 1;
+    err = start_block(buffers[active]);
+    if (err) {
+        LOG_WRN("ADC restart failed (err %d)", err);
+    }
+
+    sound_level_feed(&acc, done, BLOCK_SAMPLES);
+
+    if (k_uptime_get_32() - window_start >= CONFIG_SOUND_ADC_WINDOW_MS) {
+        struct sound_level level;
+
+        sound_level_finish(&acc, SOUND_ADC_FULL_SCALE, &level);
+        sound_level_reset(&acc);
+        window_start = k_uptime_get_32();
+        if (level_cb) {
+            level_cb(&level);
+        }
+    }
+}
+
+#ifdef CONFIG_ADC_EMUL
+/* Host runs: a 1.65 V biased triangle wave whose amplitude ramps up and
+ * down every few seconds, in mV as the emulator expects.
+ */
+static int emul_signal(const struct device *dev, unsigned int chan, void *data, uint32_t *result)
+{
+    static uint32_t n;
+    uint32_t amp = 50 + (k_uptime_get_32() / 10) % 500;
+    int32_t phase = (int32_t)(n++ % 16) - 8;
+
+    *result = 1650 + (phase * (int32_t)amp) / 8;
+    return 0;
+}
+#endif
+
+int sound_adc_init(sound_level_cb_t cb)
+{
+    int err;
+
+    if (!device_is_ready(adc_dev)) {
+        return -ENODEV;
+    }
+
+    err = adc_channel_setup(adc_dev, &channel_cfg);
+    if (err) {
+        return err;
+    }
+
+#ifdef CONFIG_ADC_EMUL
+    adc_emul_value_func_set(adc_dev, SOUND_ADC_CHANNEL, emul_signal, NULL);
+#endif
+
+    level_cb = cb;
+    k_poll_signal_init(&adc_signal);
+    sound_level_reset(&acc);
+    window_start = k_uptime_get_32();
+    active = 0;
+
+    return start_block(buffers[active]);
+}
@@ -0,0 +1,19 @@
+#ifndef SOUND_ADC_H
+#define SOUND_ADC_H
+
+#include "sound_level.h"
+
+/**
+ * @brief Sound level callback, runs on the system work queue once per window
+ */
+typedef void (*sound_level_cb_t)(const struct sound_level *level);
+
+/**
+ * @brief Configures the ADC channel from zephyr,user io-channels and starts
+ *        continuous double-buffered sampling.
+ * @param cb Called with every completed window
+ * @return 0 on success, negative error code otherwise
+ */
+int sound_adc_init(sound_level_cb_t cb);
+
+#endif
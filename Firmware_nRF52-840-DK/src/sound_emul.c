@@ -0,0 +1,65 @@
+/* sound_emul.c - Sound module stimulus for host builds
+ *
+ * Drives the sound_node input of the emulated GPIO controller the way the
+ * module's comparator does: short active pulses in bursts (a snore or a
+ * door) separated by quiet gaps. The edges go through the real GPIO
+ * callback, refractory filter and bottom half.
+ */
+
+#include <zephyr.h>
+#include <init.h>
+#include <drivers/gpio.h>
+#include <drivers/gpio/gpio_emul.h>
+
+#define SOUND_NODE DT_NODELABEL(sound_node)
+#define PULSE_MS   5
+
+static const struct gpio_dt_spec sound_gpio = GPIO_DT_SPEC_GET(SOUND_NODE, gpios);
+
+static uint32_t lcg_state = 0x536f6e64;
+static uint8_t burst_left;
+static bool active;
+
+static uint32_t rand_below(uint32_t n)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (lcg_state >> 8) % n;
+}
+
+/* Physical level for a logical state, the module output is active low */
+static int level(bool on)
+{
+    return (sound_gpio.dt_flags & GPIO_ACTIVE_LOW) ? !on : on;
+}
+
+static void stimulus_fn(struct k_timer *timer)
+{
+    uint32_t next_ms;
+
+    active = !active;
+    gpio_emul_input_set(sound_gpio.port, sound_gpio.pin, level(active));
+
+    if (active) {
+        next_ms = PULSE_MS;
+    } else if (burst_left) {
+        burst_left--;
+        next_ms = 30 + rand_below(200);
+    } else {
+        burst_left = rand_below(8);
+        next_ms = CONFIG_SOUND_EMUL_GAP_MS / 2 + rand_below(CONFIG_SOUND_EMUL_GAP_MS);
+    }
+    k_timer_start(timer, K_MSEC(next_ms), K_NO_WAIT);
+}
+
+static K_TIMER_DEFINE(stimulus_timer, stimulus_fn, NULL);
+
+static int sound_emul_init(const struct device *unused)
+{
+    ARG_UNUSED(unused);
+
+    gpio_emul_input_set(sound_gpio.port, sound_gpio.pin, level(false));
+    k_timer_start(&stimulus_timer, K_MSEC(CONFIG_SOUND_EMUL_GAP_MS), K_NO_WAIT);
+    return 0;
+}
+
+SYS_INIT(sound_emul_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
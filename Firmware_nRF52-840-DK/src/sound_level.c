@@ -0,0 +1,95 @@
+/* sound_level.c - Windowed RMS / peak / dBFS of the sound amplitude signal.
+ * The per-sample work is a fixed-point accumulate. Once per window the
+ * variance and its square root are taken in 64-bit integers; only the
+ * dBFS logarithm uses float.
+ */
+
+#include <zephyr.h>
+#include <sys/util.h>
+#include <math.h>
+
+#include "sound_level.h"
+
+/* Floor of the square root of a 64-bit value, bit by bit */
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+void sound_level_reset(struct sound_level_acc *acc)
+{
+    acc->sum = 0;
+    acc->sum_sq = 0;
+    acc->n = 0;
+    acc->min = INT16_MAX;
+    acc->max = INT16_MIN;
+}
+
+void sound_level_feed(struct sound_level_acc *acc, const int16_t *x, size_t n)
+{
+    int32_t sum = 0;
+    uint64_t sum_sq = 0;
+    int16_t lo = acc->min, hi = acc->max;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = x[i];
+
+        sum += v;
+        sum_sq += (uint32_t)(v * v);
+        lo = MIN(lo, v);
+        hi = MAX(hi, v);
+    }
+
+    acc->sum += sum;
+    acc->sum_sq += sum_sq;
+    acc->n += n;
+    acc->min = lo;
+    acc->max = hi;
+}
+
+void sound_level_finish(const struct sound_level_acc *acc, uint16_t full_scale,
+                        struct sound_level *out)
+{
+    out->samples = (uint16_t)MIN(acc->n, UINT16_MAX);
+    if (acc->n == 0) {
+        out->rms = 0;
+        out->peak = 0;
+        out->dbfs_centi = INT16_MIN;
+        return;
+    }
+
+    /* n^2 * variance = n * sum_sq - sum^2. Working on the exact integer
+     * sums keeps the DC bias (~2048 counts) from cancelling the small AC
+     * part of a quiet window, which float division would lose.
+     */
+    uint64_t n = acc->n;
+    uint64_t sum = (uint64_t)(acc->sum < 0 ? -acc->sum : acc->sum);
+    uint64_t n2_var = n * acc->sum_sq - sum * sum;
+    uint32_t root = isqrt64(n2_var);   /* n * rms */
+    int32_t mean = (int32_t)((acc->sum + (acc->sum < 0 ? -(int64_t)n : (int64_t)n) / 2) /
+                             (int64_t)n);
+
+    out->rms = (uint16_t)MIN((root + n / 2) / n, UINT16_MAX);
+    out->peak = (uint16_t)MAX(acc->max - mean, mean - acc->min);
+
+    if (root == 0) {
+        out->dbfs_centi = INT16_MIN;
+    } else {
+        out->dbfs_centi = (int16_t)(2000.0f * log10f((float)root / (float)(n * full_scale)));
+    }
+}
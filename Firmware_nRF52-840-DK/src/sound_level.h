@@ -0,0 +1,38 @@
+#ifndef SOUND_LEVEL_H
+#define SOUND_LEVEL_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+/* Amplitude summary of one sound window, in ADC counts after DC removal */
+struct sound_level {
+    uint16_t rms;
+    uint16_t peak;
+    int16_t dbfs_centi;  /* RMS relative to full scale, 0.01 dB; INT16_MIN for silence */
+    uint16_t samples;    /* samples in the window, saturating */
+};
+
+/* Running sums for one window; fed block by block */
+struct sound_level_acc {
+    int64_t sum;
+    uint64_t sum_sq;
+    uint32_t n;
+    int16_t min;
+    int16_t max;
+};
+
+void sound_level_reset(struct sound_level_acc *acc);
+
+/**
+ * @brief Adds a block of raw ADC samples. Integer-only inner loop.
+ */
+void sound_level_feed(struct sound_level_acc *acc, const int16_t *x, size_t n);
+
+/**
+ * @brief Computes RMS, peak and dBFS for the window fed so far.
+ * @param full_scale ADC count that corresponds to 0 dBFS
+ */
+void sound_level_finish(const struct sound_level_acc *acc, uint16_t full_scale,
+                        struct sound_level *out);
+
+#endif
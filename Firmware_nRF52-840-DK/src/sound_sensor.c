@@ -1,20 +1,99 @@
 #include <kernel.h>
 #include <drivers/gpio.h>
+#include <sys/atomic.h>
 #include "sound_sensor.h"
 
+/* The ISR only timestamps edges into a single-producer/single-consumer
+ * ring; everything else happens in a work item. The refractory window
+ * bounds the accepted event rate and the ring bounds memory, so a burst
+ * storm costs at most one cycle read and a compare per edge.
+ */
+#define EVENT_RING_SIZE CONFIG_SOUND_EVENT_RING_SIZE
+#define EVENT_RING_MASK (EVENT_RING_SIZE - 1)
+
+BUILD_ASSERT((EVENT_RING_SIZE & EVENT_RING_MASK) == 0,
+             "CONFIG_SOUND_EVENT_RING_SIZE must be a power of two");
+
 // Define the GPIO spec from the devicetree
-/* Use 'sound_node' as defined in the overlay above */
+/* Use 'sound_node' as defined in app.overlay */
 static const struct gpio_dt_spec sound_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(sound_node), gpios);
 static struct gpio_callback sound_cb_data;
 static sound_callback_t user_cb = NULL;
 
+static uint32_t event_ring[EVENT_RING_SIZE];
+static atomic_t ring_head;  /* written by the ISR only */
+static atomic_t ring_tail;  /* written by the work item only */
+static atomic_t work_pending;
+
+static uint32_t refractory_cycles;
+static uint32_t last_accepted;
+static struct sound_stats stats;
+
+static void sound_work_fn(struct k_work *work);
+static K_WORK_DEFINE(sound_work, sound_work_fn);
+
 // This function runs whenever the pin changes state
-void sound_gpio_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins) {
+static void sound_gpio_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins) {
+    uint32_t now = k_cycle_get_32();
+    uint32_t head = (uint32_t)atomic_get(&ring_head);
+
+    if (stats.accepted && (now - last_accepted) < refractory_cycles) {
+        stats.coalesced++;
+        return;
+    }
+
+    if (head - (uint32_t)atomic_get(&ring_tail) >= EVENT_RING_SIZE) {
+        stats.dropped++;
+        return;
+    }
+
+    last_accepted = now;
+    stats.accepted++;
+    event_ring[head & EVENT_RING_MASK] = now;
+    atomic_set(&ring_head, head + 1);
+
+    if (!atomic_set(&work_pending, 1)) {
+        k_work_submit(&sound_work);
+    }
+}
+
+/* Bottom half: hand every queued timestamp to the user in one batch */
+static void sound_work_fn(struct k_work *work) {
+    uint32_t batch[EVENT_RING_SIZE];
+    size_t count = 0;
+
+    /* Clear first so an edge arriving during the drain resubmits */
+    atomic_set(&work_pending, 0);
+
+    uint32_t head = (uint32_t)atomic_get(&ring_head);
+    uint32_t tail = (uint32_t)atomic_get(&ring_tail);
+
+    while (tail != head) {
+        batch[count++] = event_ring[tail & EVENT_RING_MASK];
+        tail++;
+    }
+    atomic_set(&ring_tail, tail);
+
+    if (count == 0) {
+        return;
+    }
+    stats.batches++;
     if (user_cb) {
-        user_cb();
+        user_cb(batch, count);
     }
 }
 
+void sound_sensor_set_refractory_us(uint32_t us) {
+    refractory_cycles = k_us_to_cyc_ceil32(us);
+}
+
+void sound_sensor_get_stats(struct sound_stats *out) {
+    unsigned int key = irq_lock();
+
+    *out = stats;
+    irq_unlock(key);
+}
+
 int sound_sensor_init(sound_callback_t cb) {
     int ret;
 
@@ -23,6 +102,7 @@ int sound_sensor_init(sound_callback_t cb) {
     }
 
     user_cb = cb;
+    sound_sensor_set_refractory_us(CONFIG_SOUND_REFRACTORY_US);
 
     // Configure pin as input
     ret = gpio_pin_configure_dt(&sound_gpio, GPIO_INPUT);
@@ -34,4 +114,4 @@ int sound_sensor_init(sound_callback_t cb) {
     
     ret = gpio_pin_interrupt_configure_dt(&sound_gpio, GPIO_INT_EDGE_TO_ACTIVE);
     return ret;
-}
\ No newline at end of file
+}
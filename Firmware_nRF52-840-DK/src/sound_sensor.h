@@ -1,18 +1,40 @@
 #ifndef SOUND_SENSOR_H
 #define SOUND_SENSOR_H
 
+#include <zephyr/types.h>
+#include <stddef.h>
 #include <drivers/gpio.h>
 
 /**
- * @brief Type definition for the sound detection callback function
+ * @brief Bottom-half callback, runs on the system work queue with the
+ *        k_cycle_get_32() timestamps of the edges accepted since the last call
  */
-typedef void (*sound_callback_t)(void);
+typedef void (*sound_callback_t)(const uint32_t *stamps, size_t count);
+
+/* ISR counters; together with delivered they account for every edge */
+struct sound_stats {
+    uint32_t accepted;   /* queued for the bottom half */
+    uint32_t coalesced;  /* inside the refractory window of the previous edge */
+    uint32_t dropped;    /* event ring full */
+    uint32_t batches;    /* bottom-half runs */
+};
 
 /**
  * @brief Initializes the sound sensor GPIO and interrupts
- * @param cb The function to call when a sound jump is detected
+ * @param cb The function to call with each batch of detected sound jumps
  * @return 0 on success, negative error code otherwise
  */
 int sound_sensor_init(sound_callback_t cb);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Sets the debounce/refractory window; edges closer than this to the
+ *        previously accepted one are coalesced into it.
+ */
+void sound_sensor_set_refractory_us(uint32_t us);
+
+/**
+ * @brief Copies the current ISR and bottom-half counters.
+ */
+void sound_sensor_get_stats(struct sound_stats *stats);
+
+#endif
@@ -0,0 +1,68 @@
+/* sound_window.c - Fixed-window aggregation of sound events.
+ * All calls come from the system work queue (sound bottom half and the
+ * scheduler), so the open window needs no locking.
+ */
+
+#include <zephyr.h>
+#include <kernel.h>
+#include <sys/util.h>
+
+#include "sound_window.h"
+
+BUILD_ASSERT(CONFIG_SOUND_WINDOW_MS < SOUND_WINDOW_NO_EVENT,
+             "window offsets are stored in 16 bits");
+
+static struct sound_window open_win;
+static uint32_t start_cyc;
+static uint32_t last_stamp;
+static bool have_last;
+
+static void window_open(void)
+{
+    open_win.start_ms = k_uptime_get_32();
+    open_win.events = 0;
+    open_win.peak_rate_dhz = 0;
+    open_win.first_ms = SOUND_WINDOW_NO_EVENT;
+    open_win.last_ms = SOUND_WINDOW_NO_EVENT;
+    start_cyc = k_cycle_get_32();
+}
+
+void sound_window_init(void)
+{
+    have_last = false;
+    window_open();
+}
+
+void sound_window_add(const uint32_t *stamps, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint32_t stamp = stamps[i];
+        int32_t since_start = (int32_t)(stamp - start_cyc);
+        /* Edges queued just before the window rolled over count at offset 0 */
+        uint16_t offset = (uint16_t)MIN(k_cyc_to_ms_floor32(MAX(since_start, 0)),
+                                        CONFIG_SOUND_WINDOW_MS);
+
+        if (open_win.events < UINT16_MAX) {
+            open_win.events++;
+        }
+        if (open_win.first_ms == SOUND_WINDOW_NO_EVENT) {
+            open_win.first_ms = offset;
+        }
+        open_win.last_ms = offset;
+
+        /* Peak rate also spans the gap to the previous window's last event */
+        if (have_last && stamp != last_stamp) {
+            uint64_t rate = (uint64_t)sys_clock_hw_cycles_per_sec() * 10U / (stamp - last_stamp);
+
+            open_win.peak_rate_dhz = MAX(open_win.peak_rate_dhz, (uint16_t)MIN(rate, UINT16_MAX));
+        }
+        last_stamp = stamp;
+        have_last = true;
+    }
+}
+
+void sound_window_close(struct sound_window *out)
+{
+    *out = open_win;
+    window_open();
+}
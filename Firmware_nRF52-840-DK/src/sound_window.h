@@ -0,0 +1,34 @@
+#ifndef SOUND_WINDOW_H
+#define SOUND_WINDOW_H
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#define SOUND_WINDOW_NO_EVENT 0xFFFF
+
+/* Aggregate of the sound events detected in one fixed window */
+struct sound_window {
+    uint32_t start_ms;       /* k_uptime_get_32() when the window opened */
+    uint16_t events;         /* events in the window, saturating */
+    uint16_t peak_rate_dhz;  /* highest rate between consecutive events, 0.1 events/s */
+    uint16_t first_ms;       /* offset of the first event, SOUND_WINDOW_NO_EVENT if none */
+    uint16_t last_ms;        /* offset of the last event, SOUND_WINDOW_NO_EVENT if none */
+};
+
+/**
+ * @brief Opens a fresh window and forgets the previous event. Call once
+ *        before adding events; calling it again restarts the open window.
+ */
+void sound_window_init(void);
+
+/**
+ * @brief Adds a batch of k_cycle_get_32() event timestamps to the open window.
+ */
+void sound_window_add(const uint32_t *stamps, size_t count);
+
+/**
+ * @brief Closes the open window into out and opens the next one.
+ */
+void sound_window_close(struct sound_window *out);
+
+#endif
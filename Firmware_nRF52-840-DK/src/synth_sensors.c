@@ -0,0 +1,40 @@
+/* synth_sensors.c - Synthetic gas and environment readings */
+
+#include <zephyr.h>
+#include <sys/util.h>
+
+#include "synth_sensors.h"
+
+static uint32_t lcg_state = 0x536f6d4e;
+
+/* Uniform step in [-1, 1) */
+static float step(void)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (float)(int32_t)(lcg_state >> 8) / (float)BIT(23) - 1.0f;
+}
+
+static float walk(float *v, float stride, float lo, float hi)
+{
+    *v = CLAMP(*v + step() * stride, lo, hi);
+    return *v;
+}
+
+static float co = 1.5f, no2 = 0.08f, nh3 = 0.9f, ch4 = 2.0f, etoh = 4.0f;
+static float temp = 21.0f, hum = 45.0f;
+
+void synth_read_gas(struct gas_data *data)
+{
+    data->co = walk(&co, 0.05f, 0.0f, 50.0f);
+    data->no2 = walk(&no2, 0.01f, 0.0f, 5.0f);
+    data->nh3 = walk(&nh3, 0.05f, 0.0f, 20.0f);
+    data->ch4 = walk(&ch4, 0.1f, 0.0f, 100.0f);
+    data->etoh = walk(&etoh, 0.2f, 0.0f, 100.0f);
+    data->valid = GAS_VALID_ALL;
+}
+
+void synth_read_env(float *temp_c, float *hum_pct)
+{
+    *temp_c = walk(&temp, 0.1f, 15.0f, 30.0f);
+    *hum_pct = walk(&hum, 0.5f, 20.0f, 80.0f);
+}
@@ -0,0 +1,22 @@
+#ifndef SYNTH_SENSORS_H
+#define SYNTH_SENSORS_H
+
+#include "gas_sensor.h"
+
+/* Deterministic stand-ins for the gas sensor and the DHT11 on boards
+ * without them (nrf52_bsim). Every channel follows its own bounded random
+ * walk around a plausible bedroom value, so deltas, batching and the
+ * codec see realistic data and two runs produce the same stream.
+ */
+
+/**
+ * @brief Next gas reading; every channel is marked valid.
+ */
+void synth_read_gas(struct gas_data *data);
+
+/**
+ * @brief Next temperature (C) and relative humidity (%) reading.
+ */
+void synth_read_env(float *temp_c, float *hum_pct);
+
+#endif
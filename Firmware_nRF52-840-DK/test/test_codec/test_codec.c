@@ -0,0 +1,180 @@
+/* test_codec.c - Flash log codec round trips on the host: every record
+ * decoded from a block must equal the one encoded into it, at the 0.01
+ * resolution the codec keeps.
+ */
+
+#include <unity.h>
+#include <string.h>
+
+#include "sample_codec.h"
+#include "snapshot.h"
+#include "synth_sensors.h"
+
+#define BLOCK_MAX     240   /* SAMPLE_STORE_BLOCK_MAX */
+#define BLOCK_HDR_LEN 12    /* SAMPLE_STORE_BLOCK_HDR_LEN */
+#define RECORDS       4096
+
+static struct sample set[RECORDS];
+static uint8_t blk[BLOCK_MAX];
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void assert_same_quantized(const struct sample *want, const struct sample *got)
+{
+    TEST_ASSERT_EQUAL_UINT8(want->kind, got->kind);
+    TEST_ASSERT_EQUAL_UINT32(want->timestamp_ms, got->timestamp_ms);
+
+    switch (want->kind) {
+    case SAMPLE_GAS:
+        TEST_ASSERT_EQUAL_UINT8(want->gas.valid, got->gas.valid);
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->gas.co), snapshot_centi_u16(got->gas.co));
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->gas.no2), snapshot_centi_u16(got->gas.no2));
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->gas.nh3), snapshot_centi_u16(got->gas.nh3));
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->gas.ch4), snapshot_centi_u16(got->gas.ch4));
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->gas.etoh), snapshot_centi_u16(got->gas.etoh));
+        break;
+    case SAMPLE_ENV:
+        TEST_ASSERT_EQUAL_INT16(snapshot_centi_i16(want->env.temp_c),
+                                snapshot_centi_i16(got->env.temp_c));
+        TEST_ASSERT_EQUAL_UINT16(snapshot_centi_u16(want->env.hum_pct),
+                                 snapshot_centi_u16(got->env.hum_pct));
+        break;
+    case SAMPLE_SOUND:
+        TEST_ASSERT_EQUAL_UINT16(want->sound.events, got->sound.events);
+        TEST_ASSERT_EQUAL_UINT16(want->sound.peak_rate_dhz, got->sound.peak_rate_dhz);
+        TEST_ASSERT_EQUAL_UINT16(want->sound.first_ms, got->sound.first_ms);
+        TEST_ASSERT_EQUAL_UINT16(want->sound.last_ms, got->sound.last_ms);
+        break;
+    case SAMPLE_SOUND_LEVEL:
+        TEST_ASSERT_EQUAL_UINT16(want->sound_level.rms, got->sound_level.rms);
+        TEST_ASSERT_EQUAL_UINT16(want->sound_level.peak, got->sound_level.peak);
+        TEST_ASSERT_EQUAL_INT16(want->sound_level.dbfs_centi, got->sound_level.dbfs_centi);
+        break;
+    }
+}
+
+/* Packs records into blocks the way sample_store does, decodes every block
+ * back and compares each record with its original
+ */
+static void round_trip(const struct sample *in, size_t count)
+{
+    size_t first = 0;
+
+    while (first < count) {
+        struct sample_codec enc, dec;
+        size_t len = BLOCK_HDR_LEN, n = 0;
+
+        sample_codec_reset(&enc, in[first].timestamp_ms);
+        while (first + n < count && len + SAMPLE_CODEC_RECORD_MAX <= sizeof(blk)) {
+            int w = sample_codec_encode(&enc, &in[first + n], &blk[len], sizeof(blk) - len);
+
+            TEST_ASSERT_GREATER_THAN_INT(0, w);
+            len += w;
+            n++;
+        }
+
+        size_t off = BLOCK_HDR_LEN;
+
+        sample_codec_reset(&dec, in[first].timestamp_ms);
+        for (size_t r = 0; r < n; r++) {
+            struct sample out = { 0 };
+            int m = sample_codec_decode(&dec, &blk[off], len - off, &out);
+
+            TEST_ASSERT_GREATER_THAN_INT(0, m);
+            assert_same_quantized(&in[first + r], &out);
+            off += m;
+        }
+        TEST_ASSERT_EQUAL_size_t(len, off);
+        first += n;
+    }
+}
+
+static void test_round_trip_synth(void)
+{
+    for (size_t i = 0; i < RECORDS; i++) {
+        struct sample *smp = &set[i];
+
+        memset(smp, 0, sizeof(*smp));
+        smp->timestamp_ms = i * 1000;
+        if (i & 1) {
+            smp->kind = SAMPLE_ENV;
+            synth_read_env(&smp->env.temp_c, &smp->env.hum_pct);
+        } else {
+            smp->kind = SAMPLE_GAS;
+            synth_read_gas(&smp->gas);
+        }
+    }
+    round_trip(set, RECORDS);
+}
+
+/* Field limits, partial validity and the largest steps between records */
+static void test_round_trip_extremes(void)
+{
+    static const struct sample in[] = {
+        { .kind = SAMPLE_GAS, .timestamp_ms = 0,
+          .gas = { 0.0f, 655.35f, 0.0f, 655.35f, 0.0f, GAS_VALID_ALL } },
+        { .kind = SAMPLE_GAS, .timestamp_ms = 1,
+          .gas = { 655.35f, 0.0f, 655.35f, 0.0f, 655.35f, BIT(0) | BIT(3) } },
+        { .kind = SAMPLE_ENV, .timestamp_ms = 0x7fffffff,
+          .env = { -327.68f, 0.0f } },
+        { .kind = SAMPLE_ENV, .timestamp_ms = 0xffffffff,
+          .env = { 327.67f, 655.35f } },
+        { .kind = SAMPLE_SOUND, .timestamp_ms = 0xffffffff,
+          .sound = { .events = UINT16_MAX, .peak_rate_dhz = 0,
+                     .first_ms = 0, .last_ms = UINT16_MAX } },
+        { .kind = SAMPLE_SOUND_LEVEL, .timestamp_ms = 0xffffffff,
+          .sound_level = { .rms = 0, .peak = UINT16_MAX, .dbfs_centi = INT16_MIN } },
+        { .kind = SAMPLE_SOUND_LEVEL, .timestamp_ms = 0xffffffff,
+          .sound_level = { .rms = UINT16_MAX, .peak = 0, .dbfs_centi = INT16_MAX } },
+    };
+
+    round_trip(in, ARRAY_SIZE(in));
+}
+
+static void test_decode_truncated(void)
+{
+    struct sample smp = { .kind = SAMPLE_GAS, .timestamp_ms = 5000,
+                          .gas = { 1.5f, 0.08f, 0.9f, 2.0f, 4.0f, GAS_VALID_ALL } };
+    struct sample_codec enc, dec;
+    struct sample out;
+    int len;
+
+    sample_codec_reset(&enc, 0);
+    len = sample_codec_encode(&enc, &smp, blk, sizeof(blk));
+    TEST_ASSERT_GREATER_THAN_INT(2, len);
+
+    for (int cut = 0; cut < len; cut++) {
+        sample_codec_reset(&dec, 0);
+        TEST_ASSERT_EQUAL_INT(-EINVAL, sample_codec_decode(&dec, blk, cut, &out));
+    }
+
+    blk[0] = SAMPLE_KIND_COUNT;
+    sample_codec_reset(&dec, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, sample_codec_decode(&dec, blk, len, &out));
+}
+
+static void test_encode_short_buffer(void)
+{
+    struct sample smp = { .kind = SAMPLE_ENV, .env = { 21.0f, 45.0f } };
+    struct sample_codec enc;
+
+    sample_codec_reset(&enc, 0);
+    TEST_ASSERT_EQUAL_INT(-ENOSPC,
+                          sample_codec_encode(&enc, &smp, blk, SAMPLE_CODEC_RECORD_MAX - 1));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_synth);
+    RUN_TEST(test_round_trip_extremes);
+    RUN_TEST(test_decode_truncated);
+    RUN_TEST(test_encode_short_buffer);
+    return UNITY_END();
+}
@@ -0,0 +1,216 @@
+/* test_sample_ring.c - Sample ring on the host: ordering, lapped readers,
+ * latest-by-kind lookups and the per-slot sequence check under real
+ * concurrency (one producer thread against two reader threads).
+ */
+
+#include <unity.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "sample_ring.h"
+
+#define RING_SIZE      CONFIG_SAMPLE_RING_SIZE
+#define STRESS_RECORDS 200000
+#define STRESS_READERS 2
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static uint32_t publish_gas(float v)
+{
+    struct sample smp = { .kind = SAMPLE_GAS };
+
+    smp.gas.co = smp.gas.no2 = smp.gas.nh3 = smp.gas.ch4 = smp.gas.etoh = v;
+    return sample_ring_publish(&smp);
+}
+
+static void test_read_in_order(void)
+{
+    struct sample_reader reader;
+    struct sample smp;
+    uint32_t first;
+
+    sample_reader_init(&reader);
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, sample_ring_read(&reader, &smp));
+
+    first = publish_gas(1.0f);
+    for (int i = 2; i <= 5; i++) {
+        TEST_ASSERT_EQUAL_UINT32(first + i - 1, publish_gas((float)i));
+    }
+
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_EQUAL_INT(0, sample_ring_read(&reader, &smp));
+        TEST_ASSERT_EQUAL_UINT32(first + i - 1, smp.seq);
+        TEST_ASSERT_EQUAL_FLOAT((float)i, smp.gas.etoh);
+    }
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, sample_ring_read(&reader, &smp));
+    TEST_ASSERT_EQUAL_UINT32(0, reader.lost);
+}
+
+/* A reader more than a ring behind resumes at the oldest record left */
+static void test_lapped_reader_counts_lost(void)
+{
+    struct sample_reader reader;
+    struct sample smp;
+    uint32_t last = 0;
+
+    sample_reader_init(&reader);
+    for (int i = 0; i < RING_SIZE + 5; i++) {
+        last = publish_gas((float)i);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, sample_ring_read(&reader, &smp));
+    TEST_ASSERT_EQUAL_UINT32(last - RING_SIZE + 1, smp.seq);
+    TEST_ASSERT_EQUAL_UINT32(5, reader.lost);
+
+    for (int i = 1; i < RING_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, sample_ring_read(&reader, &smp));
+    }
+    TEST_ASSERT_EQUAL_UINT32(last, smp.seq);
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, sample_ring_read(&reader, &smp));
+}
+
+static void test_latest_by_kind(void)
+{
+    struct sample env = { .kind = SAMPLE_ENV, .env = { 21.5f, 40.0f } };
+    struct sample out;
+
+    publish_gas(7.0f);
+    sample_ring_publish(&env);
+
+    TEST_ASSERT_EQUAL_INT(0, sample_ring_latest(SAMPLE_GAS, &out));
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, out.gas.co);
+    TEST_ASSERT_EQUAL_INT(0, sample_ring_latest(SAMPLE_ENV, &out));
+    TEST_ASSERT_EQUAL_UINT32(env.seq, out.seq);
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, out.env.temp_c);
+
+    /* Pushed out of the ring by newer records of other kinds */
+    for (int i = 0; i < RING_SIZE; i++) {
+        publish_gas(0.0f);
+    }
+    TEST_ASSERT_EQUAL_INT(-ENOENT, sample_ring_latest(SAMPLE_ENV, &out));
+}
+
+/* Every payload field carries the record's seq, so a copy mixing two
+ * records shows up as a mismatch
+ */
+struct stress_reader {
+    pthread_t thread;
+    struct sample_reader reader;
+    uint32_t consumed;
+    uint32_t torn;
+    uint32_t out_of_order;
+};
+
+static struct stress_reader stress_readers[STRESS_READERS];
+static volatile int stress_done;
+
+static void *stress_producer(void *arg)
+{
+    for (uint32_t i = 0; i < STRESS_RECORDS; i++) {
+        publish_gas((float)(sample_ring_published() + 1));
+        if ((i & 0x3F) == 0) {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&stress_done, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static void *stress_reader_fn(void *arg)
+{
+    struct stress_reader *c = arg;
+    uint32_t last = 0;
+    struct sample smp;
+
+    for (;;) {
+        if (sample_ring_read(&c->reader, &smp) != 0) {
+            if (__atomic_load_n(&stress_done, __ATOMIC_SEQ_CST)) {
+                /* Published before done was set, but not read yet */
+                if (sample_ring_read(&c->reader, &smp) != 0) {
+                    return NULL;
+                }
+            } else {
+                sched_yield();
+                continue;
+            }
+        }
+
+        float v = (float)smp.seq;
+
+        if (smp.gas.co != v || smp.gas.no2 != v || smp.gas.nh3 != v ||
+            smp.gas.ch4 != v || smp.gas.etoh != v) {
+            c->torn++;
+        }
+        if (smp.seq <= last) {
+            c->out_of_order++;
+        }
+        last = smp.seq;
+        c->consumed++;
+    }
+}
+
+static void test_concurrent_readers_never_torn(void)
+{
+    pthread_t producer;
+
+    stress_done = 0;
+    for (int i = 0; i < STRESS_READERS; i++) {
+        memset(&stress_readers[i], 0, sizeof(stress_readers[i]));
+        sample_reader_init(&stress_readers[i].reader);
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&stress_readers[i].thread, NULL,
+                                                stress_reader_fn, &stress_readers[i]));
+    }
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, stress_producer, NULL));
+
+    pthread_join(producer, NULL);
+    for (int i = 0; i < STRESS_READERS; i++) {
+        struct stress_reader *c = &stress_readers[i];
+
+        pthread_join(c->thread, NULL);
+        TEST_ASSERT_EQUAL_UINT32(0, c->torn);
+        TEST_ASSERT_EQUAL_UINT32(0, c->out_of_order);
+        TEST_ASSERT_EQUAL_UINT32(STRESS_RECORDS, c->consumed + c->reader.lost);
+    }
+}
+
+static struct sample_consumer consumer;
+static uint32_t consumer_read;
+
+static void consumer_handler(struct k_work *work)
+{
+    struct sample_consumer *c = CONTAINER_OF(work, struct sample_consumer, work);
+    struct sample smp;
+
+    while (sample_ring_read(&c->reader, &smp) == 0) {
+        consumer_read++;
+    }
+}
+
+/* Runs last: a subscription is never taken back */
+static void test_subscriber_woken(void)
+{
+    sample_ring_subscribe(&consumer, NULL, consumer_handler);
+    publish_gas(1.0f);
+    publish_gas(2.0f);
+
+    TEST_ASSERT_EQUAL_UINT32(2, consumer_read);
+    TEST_ASSERT_EQUAL_UINT32(0, consumer.reader.lost);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_read_in_order);
+    RUN_TEST(test_lapped_reader_counts_lost);
+    RUN_TEST(test_latest_by_kind);
+    RUN_TEST(test_concurrent_readers_never_torn);
+    RUN_TEST(test_subscriber_woken);
+    return UNITY_END();
+}
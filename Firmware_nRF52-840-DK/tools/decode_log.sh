@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Turns the dictionary log of a build with overlay-dictlog.conf back into
+# text lines. The device only sends hex-encoded message arguments; the
+# format strings live in the build's log_dictionary.json and Zephyr's
+# log_parser.py joins both. Needs ZEPHYR_BASE.
+#
+#   tools/decode_log.sh <build dir> <capture file>
+#   tools/decode_log.sh <build dir> <serial port>   (captures until Ctrl-C)
+#
+# LOG_BAUD sets the port speed, 115200 by default.
+set -eu
+
+build=${1:?build directory}
+capture=${2:?capture file or serial port}
+db=$build/zephyr/log_dictionary.json
+
+: "${ZEPHYR_BASE:?}"
+[ -f "$db" ] || { echo "$db missing, not a dictionary logging build?" >&2; exit 1; }
+
+# The parser needs the whole log at once, so a port is read into a file
+if [ -c "$capture" ]; then
+    tmp=$(mktemp)
+    trap 'rm -f "$tmp"' EXIT
+    stty -F "$capture" "${LOG_BAUD:-115200}" raw -echo
+    echo "Capturing $capture, Ctrl-C to decode" >&2
+    trap ':' INT
+    cat "$capture" > "$tmp" || true
+    trap - INT
+    capture=$tmp
+fi
+
+python3 "$ZEPHYR_BASE/scripts/logging/dictionary/log_parser.py" --hex "$db" "$capture"